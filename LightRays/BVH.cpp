@@ -0,0 +1,79 @@
+#include "BVH.h"
+#include <algorithm>
+
+void BVH::boite_t::englobe (const boite_t& o) {
+	x_min = std::min(x_min, o.x_min); y_min = std::min(y_min, o.y_min);
+	x_max = std::max(x_max, o.x_max); y_max = std::max(y_max, o.y_max);
+}
+
+// Construction de l'arbre : boîtes englobant les cercles d'extension des objets,
+//  puis découpage récursif à la médiane des centres selon l'axe le plus étendu
+//
+void BVH::construire (const std::vector< std::shared_ptr<Objet> >& objets) {
+	noeuds.clear();
+	indices.clear();
+	n_objets_constr = objets.size();
+	std::vector<boite_t> boites;
+	std::vector<point_t> centres;
+	for (size_t i = 0; i < objets.size(); i++) {
+		if (not objets[i])
+			continue;
+		Objet::extension_t ext = objets[i]->objet_extension();
+		indices.push_back(i);
+		boites.push_back({ ext.pos.x - ext.rayon, ext.pos.y - ext.rayon,
+		                   ext.pos.x + ext.rayon, ext.pos.y + ext.rayon });
+		centres.push_back(ext.pos);
+	}
+	if (indices.empty())
+		return;
+	noeuds.reserve(2 * indices.size() / n_objets_feuille + 1);
+	noeuds.push_back({});
+	construire_recur(0, boites, centres, 0, indices.size());
+}
+
+// Construction récursive du sous-arbre de racine `noeuds[i_noeud]` contenant les objets
+//  `indices[beg..end]`. `boites` et `centres` sont permutés en même temps que `indices`.
+//
+void BVH::construire_recur (uint32_t i_noeud, std::vector<boite_t>& boites, std::vector<point_t>& centres, uint32_t beg, uint32_t end) {
+	noeud_t n;
+	n.boite = boites[beg];
+	boite_t boite_centres = { centres[beg].x, centres[beg].y, centres[beg].x, centres[beg].y };
+	for (uint32_t k = beg+1; k < end; k++) {
+		n.boite.englobe(boites[k]);
+		boite_centres.englobe({ centres[k].x, centres[k].y, centres[k].x, centres[k].y });
+	}
+	if (end - beg <= n_objets_feuille) {
+		n.premier = beg;
+		n.n_objets = end - beg;
+		noeuds[i_noeud] = n;
+		return;
+	}
+	// découpage à la médiane selon l'axe le plus étendu
+	bool axe_x = (boite_centres.x_max - boite_centres.x_min) >= (boite_centres.y_max - boite_centres.y_min);
+	uint32_t mid = (beg + end) / 2;
+	std::vector<uint32_t> perm (end - beg);
+	for (uint32_t k = 0; k < end - beg; k++)
+		perm[k] = beg + k;
+	std::nth_element(perm.begin(), perm.begin() + (mid - beg), perm.end(), [&] (uint32_t i, uint32_t j) {
+		return axe_x ? (centres[i].x < centres[j].x) : (centres[i].y < centres[j].y);
+	});
+	std::vector<uint32_t> indices_perm (end - beg);
+	std::vector<boite_t> boites_perm (end - beg);
+	std::vector<point_t> centres_perm (end - beg);
+	for (uint32_t k = 0; k < end - beg; k++) {
+		indices_perm[k] = indices[perm[k]];
+		boites_perm[k] = boites[perm[k]];
+		centres_perm[k] = centres[perm[k]];
+	}
+	std::copy(indices_perm.begin(), indices_perm.end(), indices.begin() + beg);
+	std::copy(boites_perm.begin(), boites_perm.end(), boites.begin() + beg);
+	std::copy(centres_perm.begin(), centres_perm.end(), centres.begin() + beg);
+	// les deux fils sont contigus dans `noeuds`
+	n.premier = noeuds.size();
+	n.n_objets = 0;
+	noeuds[i_noeud] = n;
+	noeuds.push_back({});
+	noeuds.push_back({});
+	construire_recur(n.premier,   boites, centres, beg, mid);
+	construire_recur(n.premier+1, boites, centres, mid, end);
+}
@@ -0,0 +1,131 @@
+/*******************************************************************************
+ * Hiérarchie de volumes englobants (BVH) des objets de la scène, pour éviter
+ *  de tester l'interception de chaque rayon avec tous les objets.
+ *******************************************************************************/
+
+#ifndef _LIGHTRAYS_BVH_H_
+#define _LIGHTRAYS_BVH_H_
+
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include "Objet.h"
+
+//------------------------------------------------------------------------------
+// Arbre binaire de boîtes englobantes alignées sur les axes, construit à partir
+//  des extensions `Objet::objet_extension()` (cercles, donc pessimistes) des
+//  objets. Les feuilles contiennent au plus `n_objets_feuille` indices d'objets.
+// L'arbre ne possède pas les objets, il doit être reconstruit dès que ceux-ci
+//  bougent (typiquement, une fois par frame).
+
+class BVH {
+public:
+	// Boîte englobante alignée sur les axes
+	struct boite_t {
+		float x_min, y_min, x_max, y_max;
+		void englobe (const boite_t& o);
+		// Intersection avec la demi-droite d'origine `o` et d'inverse de vecteur directeur `inv_u` :
+		//  renvoie la distance d'entrée dans la boîte (0 si l'origine est à l'intérieur), ou Inf
+		float intersection (point_t o, vec_t inv_u) const;
+	};
+
+	static constexpr size_t n_objets_feuille = 4;
+
+private:
+	// Nœud de l'arbre : si `n_objets` = 0, nœud interne dont les fils sont `premier` et `premier+1`,
+	//  sinon feuille contenant les objets `indices[premier..premier+n_objets]`
+	struct noeud_t {
+		boite_t boite;
+		uint32_t premier;
+		uint32_t n_objets;
+	};
+	std::vector<noeud_t> noeuds;
+	std::vector<uint32_t> indices; // indices des objets dans le vecteur d'objets de la scène
+	size_t n_objets_constr = 0;
+
+	void construire_recur (uint32_t i_noeud, std::vector<boite_t>& boites, std::vector<point_t>& centres, uint32_t beg, uint32_t end);
+
+public:
+
+	BVH () = default;
+
+	// Construction de l'arbre à partir de la liste d'objets (peut contenir des pointeurs nuls, ignorés)
+	void construire (const std::vector< std::shared_ptr<Objet> >& objets);
+	// Nombre d'objets de la liste lors de la construction
+	size_t taille () const { return n_objets_constr; }
+
+	// Parcours de l'arbre, d'avant en arrière, pour le rayon `ray` : `test_objet(i)` est appelé pour
+	//  chaque objet d'indice `i` dont la boîte englobante est traversée par le rayon, et doit renvoyer
+	//  le `Objet::intercept_t` de l'objet. Les nœuds plus éloignés que la plus proche interception
+	//  déjà trouvée sont ignorés.
+	// Renvoie l'indice de l'objet interceptant au plus proche (et son interception dans `intercept_min`),
+	//  ou `SIZE_MAX` si aucun. En cas d'égalité de distance, l'objet de plus petit indice est choisi
+	//  (même choix que le test linéaire).
+	template <typename F>
+	size_t parcours (const Rayon& ray, F&& test_objet, Objet::intercept_t& intercept_min) const;
+};
+
+// Intersection demi-droite / boîte par la méthode des "slabs" (comme Objet_Brouillard). Une composante
+//  nulle du vecteur directeur (inverse infini) est traitée à part : le produit 0 × Inf d'une origine
+//  sur un bord de la boîte donnerait NaN
+//
+inline float BVH::boite_t::intersection (point_t o, vec_t inv_u) const {
+	float t_entree = 0, t_sortie = Inf;
+	auto slab = [&] (float p, float inv, float v_min, float v_max) -> bool {
+		if (std::isinf(inv))
+			return v_min <= p and p <= v_max;
+		float t1 = (v_min - p) * inv, t2 = (v_max - p) * inv;
+		t_entree = std::max(t_entree, std::min(t1,t2));
+		t_sortie = std::min(t_sortie, std::max(t1,t2));
+		return true;
+	};
+	if (not slab(o.x, inv_u.x, x_min, x_max) or not slab(o.y, inv_u.y, y_min, y_max) or t_entree > t_sortie)
+		return Inf;
+	return t_entree;
+}
+
+template <typename F>
+size_t BVH::parcours (const Rayon& ray, F&& test_objet, Objet::intercept_t& intercept_min) const {
+	intercept_min = { .t = Inf, .intercept_struct = nullptr };
+	size_t i_min = SIZE_MAX;
+	if (noeuds.empty())
+		return i_min;
+	vec_t inv_u = { 1.f/ray.dir.x, 1.f/ray.dir.y };
+	// pile des nœuds à visiter, avec leur distance d'entrée
+	struct a_visiter_t { uint32_t noeud; float dist; };
+	a_visiter_t pile [64];
+	size_t n_pile = 0;
+	float d0 = noeuds[0].boite.intersection(ray.orig, inv_u);
+	if (d0 != Inf)
+		pile[n_pile++] = { 0, d0 };
+	while (n_pile != 0) {
+		a_visiter_t v = pile[--n_pile];
+		if (v.dist > intercept_min.t)
+			continue;
+		const noeud_t& n = noeuds[v.noeud];
+		if (n.n_objets != 0) {
+			for (uint32_t k = n.premier; k < n.premier + n.n_objets; k++) {
+				Objet::intercept_t intercept = test_objet((size_t)indices[k]);
+				if (intercept.t < intercept_min.t or (intercept.t == intercept_min.t and intercept.t != Inf and indices[k] < i_min)) {
+					intercept_min = intercept;
+					i_min = indices[k];
+				}
+			}
+		} else {
+			float da = noeuds[n.premier  ].boite.intersection(ray.orig, inv_u),
+			      db = noeuds[n.premier+1].boite.intersection(ray.orig, inv_u);
+			// le fils le plus proche est empilé en dernier pour être visité en premier
+			uint32_t na = n.premier, nb = n.premier+1;
+			if (da < db) { std::swap(da, db); std::swap(na, nb); }
+			if (da != Inf) pile[n_pile++] = { na, da };
+			if (db != Inf) pile[n_pile++] = { nb, db };
+		}
+	}
+	return i_min;
+}
+
+#endif
@@ -1,98 +1,181 @@
 #include "Brouillard.h"
-#include "ObjetsCourbes.h"
 #include <cmath>
+#include <algorithm>
 
 Objet::extension_t Objet_Brouillard::objet_extension () const {
 	vec_t v = { lx*reso_x/2, ly*reso_y/2 };
 	return {
 		.pos = o + v,
-		.rayon = std::max(v.x, v.y)
+		.rayon = !v  // demi-diagonale : le cercle doit contenir tout le rectangle
 	};
 }
 
-// Test d'interception avec le brouillard : parcours du rayon à travers les cellules
-//  et décision si oui ou non on diffuserait le rayon
+// Test d'interception avec le brouillard : parcours exact des cellules traversées par le rayon
+//  (Amanatides & Woo) et décision si oui ou non on diffuserait le rayon. L'épaisseur optique
+//  est intégrée analytiquement sur chaque cellule (densité × longueur traversée), et comparée
+//  à une épaisseur optique cible tirée une seule fois par rayon.
 //
 Objet::intercept_t Objet_Brouillard::essai_intercept (const Rayon& ray) const {
 	
 	if (ray.spectre.intensite_tot() < intens_cutoff)
-		return { .dist2 = Inf, .intercept_struct = nullptr };
+		return { .t = Inf, .intercept_struct = nullptr };
 	
-	// on test si le rayon passe sur le rectange bornant le brouillard
-	std::vector<ObjetLigne::intersection_segdd_t> isects;
-	auto test_isect = [&] (point_t a, point_t b) {
-		auto isect = ObjetLigne::intersection_segment_demidroite(a, b, ray.orig, ray.dir_angle);
-		if (isect.has_value())
-			isects.push_back(isect.value());
+	// intersection du rayon avec le rectangle bornant le brouillard (méthode des "slabs")
+	vec_t p = ray.orig - this->o;
+	vec_t u = ray.dir;
+	float lx_tot = lx * reso_x,
+	      ly_tot = ly * reso_y;
+	float t_entree = 0, t_sortie = Inf;
+	auto slab = [&] (float p, float u, float l) -> bool {
+		if (u == 0)
+			return 0 <= p and p <= l;
+		float t1 = (0 - p) / u, t2 = (l - p) / u;
+		t_entree = std::max(t_entree, std::min(t1,t2));
+		t_sortie = std::min(t_sortie, std::max(t1,t2));
+		return true;
 	};
-	point_t o2 = o + vec_t{lx*reso_x,0},
-	        o3 = o + vec_t{lx*reso_x,ly*reso_y},
-	        o4 = o + vec_t{0,ly*reso_y};
-	test_isect(o , o2);
-	test_isect(o2, o3);
-	test_isect(o3, o4);
-	test_isect(o4, o );
-//	assert(isects.size() <= 2); // le rayon ne peut avoir que 1 (si source interne) ou 2 intersections (ou zéro) avec les bords
+	if (not slab(p.x, u.x, lx_tot) or not slab(p.y, u.y, ly_tot) or t_entree >= t_sortie)
+		return { .t = Inf, .intercept_struct = nullptr };
+	if (suivi_delta)
+		return this->essai_intercept_delta(ray, t_entree, t_sortie);
 	
-	if (isects.size() != 0) {
-		
-		float s;
-		float s_fin = isects[0].t_dd;
-		if (isects.size() == 1) {  // rayon émis à l'intérieur du brouillard
-			s = 0;
-		} else {  // rayon provenant de l'expérieur du brouillard
-			s = isects[1].t_dd;
-			if (s > s_fin)
-				std::swap(s, s_fin);
+	// Épaisseur optique à parcourir avant diffusion, et coefficient d'extinction :
+	// - diffusion complète : extinction = densité de la cellule, diffusion avec la probabilité
+	//   1-exp(-τ) (τ cible aléatoire), ou dès que τ atteint 1 pour le parcours déterministe
+	// - diffusion partielle systématique : extinction uniforme 1/libre parcours, la densité
+	//   donnant seulement la fraction diffusée au point de diffusion
+	bool partielle = std::isfinite(diffus_partielle_syst_libreparcours);
+	float tau_cible = parcours_deterministe ? 1 : -logf(rand01());
+	float tau = 0;
+	
+	// cellule d'entrée, et paramètres du parcours de la grille
+	vec_t q = p + t_entree * u;
+	int ix = std::clamp<int>( floorf(q.x / reso_x), 0, lx-1 ),
+	    iy = std::clamp<int>( floorf(q.y / reso_y), 0, ly-1 );
+	int pas_x = (u.x > 0) ? 1 : -1,
+	    pas_y = (u.y > 0) ? 1 : -1;
+	// distance `t` au prochain bord vertical/horizontal de cellule, et incréments entre bords
+	float t_max_x = (u.x == 0) ? Inf : ( (ix + (u.x > 0)) * reso_x - p.x ) / u.x,
+	      t_max_y = (u.y == 0) ? Inf : ( (iy + (u.y > 0)) * reso_y - p.y ) / u.y;
+	float dt_x = (u.x == 0) ? Inf : reso_x / fabsf(u.x),
+	      dt_y = (u.y == 0) ? Inf : reso_y / fabsf(u.y);
+	
+	float t0 = t_entree;
+	while (true) {
+		float t1 = std::min({ t_max_x, t_max_y, t_sortie });
+		float densit = this->densit(ix, iy);
+		float extinction = partielle ? 1 / diffus_partielle_syst_libreparcours : densit;
+		float d_tau = extinction * (t1 - t0);
+		if (tau + d_tau >= tau_cible) {
+			// rayon diffusé dans cette cellule
+			intercept_brouillard_t interception;
+			float t = t0 + (tau_cible - tau) / extinction;
+			interception.p_diff = ray.orig + t * u;
+			interception.x_diff = ix;
+			interception.y_diff = iy;
+			interception.fraction_transmis = partielle ? grille_transmis[iy*lx + ix] : 0;
+			intercept_t intercept = { .t = t, .intercept_struct = nullptr };
+			intercept.intercept_struct.creer(interception);
+			return intercept;
 		}
-		float ds = std::min(reso_x,reso_y) / 2;
-		vec_t u_ray = isects[0].u_dd;
-		// le rayon parcourt le brouillard jusqu'à s_fin par incréments de ds
-		// avec une probabilité donnée par `densit_brouillard` d'être diffusé à chaque pas, pour la méthode 1
-		// et avec une probabilité de `diffus_partielle_syst_proba`
-		intercept_brouillard_t p;
-		float proba_acc = 0;
-		
-		while (s < s_fin) {
-			p.p_diff = ray.orig + s * u_ray;
-			vec_t v = p.p_diff - this->o;
-			p.x_diff = floorf( v.x / reso_x );
-			p.y_diff = floorf( v.y / reso_y );
-			if (0 <= p.x_diff and p.x_diff < (int)this->lx and 0 <= p.y_diff and p.y_diff < (int)this->ly) {
-				
-				float proba = ds / diffus_partielle_syst_libreparcours;
-				if (proba > 1e-5) {
-					// méthode par diffusion systématique partielle
-					proba_acc += proba;
-					p.fraction_transmis = std::max<float>(0, 1 - ds/proba * this->densit_brouillard(p.x_diff, p.y_diff));
-				} else {
-					// méthode par diffusion probabiliste complète
-					proba = ds * this->densit_brouillard(p.x_diff, p.y_diff);
-					proba_acc += proba;
-					p.fraction_transmis = 0;
-				}
-				bool diffuse = parcours_deterministe ? (proba_acc >= 1) : (rand01() < proba);
-				if (diffuse) {
-					// rayon diffusé
-					s += /*rand01() */ ds;
-					p.p_diff = ray.orig + s * u_ray;
-					return { .dist2 = s*s,
-					         .intercept_struct = std::make_shared<intercept_brouillard_t>(std::move(p)) };
-				}
-				
-			}
-			s += ds;
+		tau += d_tau;
+		// cellule suivante
+		if (t1 >= t_sortie)
+			break;
+		if (t_max_x < t_max_y) {
+			ix += pas_x;
+			t_max_x += dt_x;
+		} else {
+			iy += pas_y;
+			t_max_y += dt_y;
 		}
-		
+		if (ix < 0 or ix >= (int)lx or iy < 0 or iy >= (int)ly)
+			break;
+		t0 = t1;
 	}
-	return { .dist2 = Inf, .intercept_struct = nullptr };
+	return { .t = Inf, .intercept_struct = nullptr };
 };
 
+// Suivi par majorant (delta tracking / ratio tracking) : libres parcours tirés selon `densit_max`,
+//  collisions candidates acceptées avec la probabilité densité/densit_max (diffusion complète) ou
+//  diffusant la fraction densité/densit_max du rayon (diffusion partielle)
+//
+Objet::intercept_t Objet_Brouillard::essai_intercept_delta (const Rayon& ray, float t_entree, float t_sortie) const {
+	if (not (densit_max > 0))
+		return { .t = Inf, .intercept_struct = nullptr };
+	bool partielle = std::isfinite(diffus_partielle_syst_libreparcours);
+	float t = t_entree;
+	while (true) {
+		t += -logf(rand01()) / densit_max;
+		if (t >= t_sortie)
+			break;
+		point_t p_diff = ray.orig + t * ray.dir;
+		vec_t v = p_diff - this->o;
+		int ix = std::clamp<int>( floorf(v.x / reso_x), 0, lx-1 ),
+		    iy = std::clamp<int>( floorf(v.y / reso_y), 0, ly-1 );
+		float ratio = this->densit(ix, iy) / densit_max;
+		// collision fictive : le rayon continue sans changement
+		if (partielle ? (ratio <= 0) : (rand01() >= ratio))
+			continue;
+		intercept_brouillard_t interception;
+		interception.p_diff = p_diff;
+		interception.x_diff = ix;
+		interception.y_diff = iy;
+		interception.fraction_transmis = partielle ? 1 - ratio : 0;
+		intercept_t intercept = { .t = t, .intercept_struct = nullptr };
+		intercept.intercept_struct.creer(interception);
+		return intercept;
+	}
+	return { .t = Inf, .intercept_struct = nullptr };
+}
+
+// Évaluation de la grille des densités et de la densité maximale
+//
+void Objet_Brouillard::calculer_grille () {
+	grille_densit.resize(lx * ly);
+	densit_max = 0;
+	for (uint y = 0; y < ly; y++) {
+		for (uint x = 0; x < lx; x++) {
+			float d = this->densit_brouillard(x,y);
+			grille_densit[y*lx + x] = d;
+			densit_max = std::max(densit_max, d);
+		}
+	}
+	grille_a_jour = true;
+	grille_libreparcours = NaN; // fractions transmises à recalculer
+#ifndef NOSFML
+	std::vector<sf::Uint8>& pixels = texture_pixels.ecriture();
+	pixels.resize(4 * lx * ly);
+	for (uint y = 0; y < ly; y++) {
+		for (uint x = 0; x < lx; x++) {
+			sf::Uint8* pix = &pixels[4 * ((ly-1-y)*lx + x)]; // première ligne de la texture en haut
+			pix[0] = pix[1] = pix[2] = 255;
+			pix[3] = std::min(255.f, this->densit(x,y));
+		}
+	}
+	texture_pixels.publier();
+#endif
+}
+
+void Objet_Brouillard::pre_propagation () {
+	if (not grille_a_jour)
+		calculer_grille();
+	if (std::isfinite(diffus_partielle_syst_libreparcours) and grille_libreparcours != diffus_partielle_syst_libreparcours) {
+		grille_libreparcours = diffus_partielle_syst_libreparcours;
+		grille_transmis.resize(lx * ly);
+		for (size_t i = 0; i < grille_densit.size(); i++)
+			grille_transmis[i] = std::max<float>(0, 1 - grille_libreparcours * grille_densit[i]);
+	}
+	for (color_id_t c = 0; c < N_COULEURS; c++)
+		tables_directivite[c].tabuler(0, 2*M_PI, tables_n_directivite, [&] (float theta) {
+			return directivite_diffus(theta, lambda_color[c]);
+		});
+}
+
 // Ré-émission du rayon intercepté par le brouillard
 //
-std::vector<Rayon> Objet_Brouillard::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	const intercept_brouillard_t& intercept = *(intercept_brouillard_t*)interception.get();
-	std::vector<Rayon> rayons;
+void Objet_Brouillard::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_brouillard_t& intercept = interception.get<intercept_brouillard_t>();
 	
 	// Nombre de rayons secondaires
 	size_t n_re_emit = std::max<size_t>(1, lroundf(
@@ -103,11 +186,9 @@ std::vector<Rayon> Objet_Brouillard::re_emit (const Rayon& ray, std::shared_ptr<
 	// On laisse vivre le rayon incident seulement si il a une intensité > 0.01
 	if (intercept.fraction_transmis > 0.01) {
 		Rayon ray_trsm = ray;
-		ray_trsm.spectre.for_each([&] (float lambda, pola_t, float& I) {
-			I *= intercept.fraction_transmis;
-		});
+		ray_trsm.spectre *= intercept.fraction_transmis;
 		ray_trsm.orig = intercept.p_diff;
-		rayons.push_back(std::move(ray_trsm));
+		sortie.push_back(std::move(ray_trsm));
 		
 		fact_I_re_emit *= 1 - intercept.fraction_transmis;
 	}
@@ -118,34 +199,39 @@ std::vector<Rayon> Objet_Brouillard::re_emit (const Rayon& ray, std::shared_ptr<
 		float ang_diff = 2*M_PI * rand01();
 		Rayon ray_diff;
 		ray_diff.orig = intercept.p_diff;
-		ray_diff.dir_angle = ray.dir_angle + ang_diff;
+		ray_diff.dir = ray.dir.rotate(ang_diff);
 		
 		ray_diff.spectre = ray.spectre;
-		ray_diff.spectre.for_each([&] (float lambda, pola_t, float& I) {
-			I *= this->directivite_diffus(ang_diff, lambda) * fact_I_re_emit;
+		ray_diff.spectre.for_each_cid([&] (color_id_t c, pola_t, float& I) {
+			I *= tables_directivite[c](ang_diff) * fact_I_re_emit;
 		});
 		
-		rayons.push_back(std::move(ray_diff));
+		sortie.push_back(std::move(ray_diff));
 	}
-	return rayons;
 }
 
+#ifndef NOSFML
+
 #include "sfml_c01.hpp"
 
+// Dessin du brouillard : une texture d'un pixel par cellule, d'opacité donnée par la densité
+//
 void Objet_Brouillard::dessiner (sf::RenderWindow& window, bool emphasize) const {
-	for (size_t x = 0; x < this->lx; x++) {
-		for (size_t y = 0; y < this->ly; y++) {
-			sf::RectangleShape dens;
-			sf::c01::setRectShape(dens, o + vec_t{reso_x*x, reso_y*y}, {reso_x, reso_y});
-			dens.setFillColor(sf::Color(255,255,255, std::min(255.f, this->densit_brouillard(x,y)) ));
-			window.draw(dens);
-		}
+	if (texture_pixels.actualiser()) {
+		texture.create(lx, ly);
+		texture.update(texture_pixels.lu().data());
 	}
+	sf::Sprite sprite (texture);
+	sprite.setPosition(sf::c01::toWin(o + vec_t{0, ly*reso_y}));
+	sprite.setScale(reso_x * SFMLC01_WINDOW_UNIT, reso_y * SFMLC01_WINDOW_UNIT);
+	window.draw(sprite);
 }
 
-std::optional<point_t> Objet_Brouillard::point_interception (std::shared_ptr<void> interception) const {
+#endif
+
+std::optional<point_t> Objet_Brouillard::point_interception (const intercept_struct_t& interception) const {
 	if (interception) {
-		return ((intercept_brouillard_t*)interception.get())->p_diff;
+		return interception.get<intercept_brouillard_t>().p_diff;
 	} else
 		return std::nullopt;
 }
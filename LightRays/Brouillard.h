@@ -6,22 +6,30 @@
 #define _LIGHTRAYS_BROUILLARD_H_
 
 #include "Objet.h"
+#include <array>
+#include <vector>
+#include <functional>
+#ifndef NOSFML
+#include <SFML/Graphics/Texture.hpp>
+#include "PoolThreads.h"
+#endif
 
 //------------------------------------------------------------------------------
-// Brouillard à "cellules/voxels" de densité arbitraire. Implémentation naïve,
-//  loin d'être performante.
+// Brouillard à "cellules/voxels" de densité arbitraire. Le rayon traverse la
+//  grille cellule par cellule, l'épaisseur optique étant intégrée exactement
+//  sur chaque cellule : le coût est proportionnel au nombre de cellules traversées.
 
 class Objet_Brouillard : virtual public Objet {
 public:
 	point_t o; // bottom-left corner (origine)
 	float reso_x, reso_y; // résolutions (taille d'une cellule du brouillard) dans les directions x et y
 	uint lx, ly; // taille du brouillard en nombre de cellules
-	std::function< float(size_t x, size_t y) > densit_brouillard; // fonction densité(x,y) du brouillard
+	std::function< float(size_t x, size_t y) > densit_brouillard; // fonction densité(x,y) du brouillard, évaluée dans la grille des densités (voir `densit_modifiee`)
 	std::function< float(float theta, float lambda) > directivite_diffus; // distribution angulaire des rayons diffusés, avec theta l'angle du rayon diffusé par rapport au rayon incident
 	
 	// Il y a deux techniques de diffusion (non équivalentes en terme de résultat) :
 	// - soit on diffuse totalement (en `n_re_emit_par_intens` rayons-fils, avec la directivité `directivite_diffus`)
-	//   le rayon avec une probabilité à chaque pas donnée par la densité du brouillard
+	//   le rayon avec une probabilité donnée par l'épaisseur optique (densité intégrée le long du rayon)
 	//   ("diffusion browienne")
 	//   (adapté au temps réel car peu de rayons produits, mais résultat bruité)
 	// - soit on diffuse partiellement (fraction donnée par la densité du brouillard, et en
@@ -38,18 +46,27 @@ public:
 	
 	// Parcours déterministe ou non du rayon passant à traver le brouillard. Typiquement, soit
 	//  on fait une diffusion du rayon aléatoire avec une certaine probabilité, soit on diffuse
-	//  régulièrement le rayon avec cette même "probabilité". Les deux méthodes convergent à
-	//  grande résolution.
+	//  régulièrement le rayon, à chaque unité d'épaisseur optique parcourue.
 	bool parcours_deterministe;
 	
+	// Suivi par majorant ("delta tracking" de Woodcock) : au lieu de parcourir toutes les cellules,
+	//  le rayon saute directement d'une collision candidate à la suivante, avec un libre parcours
+	//  tiré selon la densité maximale `densit_max` de la grille; la collision est réelle avec la
+	//  probabilité densité/densit_max. En diffusion partielle, chaque collision candidate diffuse la
+	//  fraction densité/densit_max du rayon et transmet le reste ("ratio tracking"), le libre parcours
+	//  valant alors 1/densit_max au lieu de `diffus_partielle_syst_libreparcours`.
+	// Toujours aléatoire (`parcours_deterministe` est ignoré). Peu coûteux pour un brouillard peu dense
+	//  ou clairsemé : quelques tirages par rayon, indépendamment du nombre de cellules traversées.
+	bool suivi_delta;
+	
 	// Les rayons d'intensité < `intens_cutoff` sont ignorés (amélioration de performance)
 	float intens_cutoff;
 	
-	// Par défaut, méthode "brownienne", directivté uniforme, parcours aléatoire, pas de cutoff
+	// Par défaut, méthode "brownienne", directivté uniforme, parcours aléatoire par cellules, pas de cutoff
 	Objet_Brouillard (point_t o, float reso_x, float reso_y, uint lx, uint ly, decltype(densit_brouillard) densit_brouillard) :
 		o(o), reso_x(reso_x), reso_y(reso_y), lx(lx), ly(ly), densit_brouillard(densit_brouillard),
 		directivite_diffus([] (float, float) { return 1.f; }),
-		n_re_emit_par_intens(5), diffus_partielle_syst_libreparcours(Inf), parcours_deterministe(false), intens_cutoff(0) {}
+		n_re_emit_par_intens(5), diffus_partielle_syst_libreparcours(Inf), parcours_deterministe(false), suivi_delta(false), intens_cutoff(0) { calculer_grille(); }
 	
 	Objet_Brouillard& operator= (const Objet_Brouillard&) = default;
 	Objet_Brouillard (const Objet_Brouillard&) = default;
@@ -63,13 +80,46 @@ public:
 	};
 	virtual intercept_t essai_intercept (const Rayon&) const override;
 	virtual extension_t objet_extension () const override;
-	virtual std::vector<Rayon> re_emit (const Rayon&, std::shared_ptr<void>) override;
-	virtual std::optional<point_t> point_interception (std::shared_ptr<void> intercept_struct) const override;
+	virtual void re_emit (const Rayon&, const intercept_struct_t&, std::vector<Rayon>& sortie) override;
+	virtual std::optional<point_t> point_interception (const intercept_struct_t& intercept_struct) const override;
+	
+	// Grille des densités (coefficients d'extinction) des cellules : `densit_brouillard` est évaluée
+	//  une fois par cellule à la construction, puis seulement si la densité a été marquée comme
+	//  modifiée par `densit_modifiee()` (ré-évaluation au début de la propagation suivante)
+	void densit_modifiee () { grille_a_jour = false; }
+	float densit (uint x, uint y) const { return grille_densit[y*lx + x]; }
+	float densit_max; // densité maximale de la grille (majorant pour `suivi_delta`)
 	
+	// Mise à jour de la grille si nécessaire, et des fractions transmises si `diffus_partielle_syst_libreparcours` a changé.
+	//  Tabulation de `directivite_diffus` pour chaque couleur (ré-évaluée à chaque propagation, peu coûteuse)
+	virtual void pre_propagation () override;
+	
+private:
+	std::vector<float> grille_densit;   // densités, cellule (x,y) à l'indice y*lx+x
+	std::vector<float> grille_transmis; // fractions transmises en diffusion partielle, pour le libre parcours `grille_libreparcours`
+	float grille_libreparcours = NaN;
+	bool grille_a_jour = false;
+	void calculer_grille ();
+	static constexpr size_t tables_n_directivite = 257; // points sur [0,2π]
+	std::array<table1d_t,N_COULEURS> tables_directivite;
+#ifndef NOSFML
+	// Texture de lx×ly pixels (un par cellule), ré-envoyée seulement quand la grille change : les pixels sont
+	//  calculés avec la grille (au début de la propagation) et publiés pour le dessin, qui peut avoir lieu
+	//  pendant la propagation (voir Scene_TestCommon::boucle)
+	mutable sf::Texture texture;
+	mutable TamponTriple< std::vector<sf::Uint8> > texture_pixels;
+#endif
+	
+	// Suivi par majorant du rayon entre les paramètres `t_entree` et `t_sortie` (dans le brouillard)
+	intercept_t essai_intercept_delta (const Rayon& ray, float t_entree, float t_sortie) const;
+	
+public:
+#ifndef NOSFML
 	// Dessin
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const override;
 	// Pas de dessin d'interception
-	virtual void dessiner_interception (sf::RenderWindow& window, const Rayon& ray, std::shared_ptr<void> intercept) const override {};
+	virtual void dessiner_interception (sf::RenderWindow& window, const Rayon& ray, const intercept_struct_t& intercept) const override {};
+#endif
 };
 
 #endif
@@ -1,7 +1,35 @@
 #include "Ecran.h"
 #include <algorithm>
 #include <cmath>
+#include "PoolThreads.h"
+#ifndef NOSFML
 #include "sfml_c01.hpp"
+#endif
+
+///------------------------ Ecran_Base ------------------------///
+
+// Variance estimée (non biaisée) des intensités par frame, divisée par le nombre de frames
+//
+double Ecran_Base::moments_t::erreur_std2 (size_t n_frames) const {
+	if (n_frames < 2)
+		return Inf;
+	double m = s1 / n_frames;
+	double var = std::max(0., s2 - n_frames * m*m) / (n_frames - 1);
+	return var / n_frames;
+}
+
+// sqrt( Σ erreur_std² ) / sqrt( Σ moyenne² ) sur les pixels
+//
+float Ecran_Base::erreur_relative (const std::vector<moments_t>& moments, size_t n_frames) {
+	if (n_frames < 2)
+		return Inf;
+	double err2 = 0, moy2 = 0;
+	for (const moments_t& m : moments) {
+		err2 += m.erreur_std2(n_frames);
+		moy2 += (m.s1 / n_frames) * (m.s1 / n_frames);
+	}
+	return (moy2 > 0) ? sqrt(err2 / moy2) : 0;
+}
 
 ///------------------------ EcranLigne_Multi ------------------------///
 
@@ -12,71 +40,106 @@ EcranLigne_Multi::EcranLigne_Multi (point_t a, point_t b, uint16_t bins_n, float
 	Ecran_Base(lumino),
 	ObjetLigne(a, b),
 	bins_intensit( std::max<size_t>(1, bins_n) ),
+	bins_moments( bins_intensit.size() ),
 	epaisseur_affich(std::nullopt)
-	{ this->reset(); }
+	{ this->preparer_threads(1); this->reset(); }
 
 void EcranLigne_Multi::reset () {
 	n_acc = 0;
-	for (Specte& intensit : bins_intensit) {
-		intensit.for_each([&] (float, pola_t, float& I) -> void {
-			I = 0;
-		});
+	std::fill(bins_intensit.begin(), bins_intensit.end(), Specte{});
+	std::fill(bins_moments.begin(), bins_moments.end(), moments_t{});
+	for (accum_thread_t& acc : accum_threads) {
+		std::fill(acc.bins.begin(), acc.bins.end(), Specte{});
+		std::fill(acc.n_impacts.begin(), acc.n_impacts.end(), 0);
 	}
+	this->publier_instantane();
 }
 
-// Accumulation des rayons dans les pixels
-//
-std::vector<Rayon> EcranLigne_Multi::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	intercept_ligne_t& intercept = *(intercept_ligne_t*)interception.get();
+void EcranLigne_Multi::preparer_threads (size_t n_threads) {
 	size_t N = bins_intensit.size();
+	accum_threads.resize(std::max<size_t>(1, n_threads), accum_thread_t{ std::vector<Specte>(N, Specte{}), std::vector<uint32_t>(N, 0) });
+}
+
+// Intensité de la frame dans chaque pixel : somme des accumulateurs des threads, ajoutée à l'accumulateur
+//  principal et aux moments
+//
+void EcranLigne_Multi::fusion_threads () {
+	for (size_t k = 0; k < bins_intensit.size(); k++) {
+		Specte sp_frame {};
+		uint32_t n_impacts = 0;
+		for (accum_thread_t& acc : accum_threads) {
+			sp_frame += acc.bins[k];
+			n_impacts += acc.n_impacts[k];
+			acc.bins[k] = Specte{};
+			acc.n_impacts[k] = 0;
+		}
+		bins_intensit[k] += sp_frame;
+		bins_moments[k].ajouter_frame(sp_frame.intensite_tot(), n_impacts);
+	}
+}
+
+// Accumulation des rayons dans les pixels (de l'accumulateur du thread courant)
+//
+void EcranLigne_Multi::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_ligne_t& intercept = interception.get<intercept_ligne_t>();
+	accum_thread_t& acc = accum_threads[PoolThreads::i_thread()];
+	size_t N = acc.bins.size();
 	ssize_t k_bin = floorf(intercept.s_incid * N);
 	if (k_bin == -1) k_bin = 0;
 	if (k_bin == (ssize_t)N) k_bin = N-1;
-	Specte::for_each_manual([&] (size_t i, float lambda, pola_t pol) -> void {
-		bins_intensit[k_bin].comps[i] += ray.spectre.comps[i];
-	});
-	return {};
+	acc.bins[k_bin] += ray.spectre;
+	acc.n_impacts[k_bin]++;
 }
 
-// Retrourne la matrice de pixels traitée
+// Calcul de la matrice de pixels traitée, publiée pour l'affichage
 //
-std::vector<EcranLigne_Multi::pixel_t> EcranLigne_Multi::matrice_pixels () const {
+void EcranLigne_Multi::publier_instantane () {
 	size_t N = this->bins_intensit.size();
 	// dans chaque pixel, c'est une puissance qu'on accumule, proportionnelle
 	// à la taille d'un pixel ( |b-a|/N ) pour une source omnidirectionnelle
 	// -> il faut diviser par la taille d'un pixel pour avoir d'intensité
 	// lumineuse (dont la luminosité RGB affichée est proportionnelle)
-	float ItoL = this->luminosite / this->n_acc * (float)N / !(b-a);
-	std::vector<pixel_t> mat (N);
+	float ItoL_err = this->luminosite * (float)N / !(b-a);
+	float ItoL = (this->n_acc > 0) ? ItoL_err / this->n_acc : 0;
+	std::vector<pixel_t>& mat = instantane.ecriture();
+	mat.resize(N);
 	for (size_t k = 0; k < N; k++) {
 		mat[k].s1 =   k   / (float)N;
 		mat[k].s2 = (k+1) / (float)N;
 		mat[k].s_mid = (mat[k].s1 + mat[k].s2) / 2;
 		mat[k].spectre = bins_intensit[k];
-		mat[k].spectre.for_each([&] (float, pola_t, float& I) -> void {
-			I *= ItoL;
-		});
+		mat[k].spectre *= ItoL;
 		std::tie(mat[k].r, mat[k].g, mat[k].b, mat[k].sat) = mat[k].spectre.rgb256_noir_intensite(false);
+		mat[k].erreur = ItoL_err * sqrt(bins_moments[k].erreur_std2(n_acc));
+		mat[k].n_impacts = bins_moments[k].n_impacts;
 	}
-	return mat;
+	instantane.publier();
 }
 
+const std::vector<EcranLigne_Multi::pixel_t>& EcranLigne_Multi::matrice_pixels () const {
+	instantane.actualiser();
+	return instantane.lu();
+}
+
+#ifndef NOSFML
 // Dessin de la matrice de pixels
 //
 void EcranLigne_Multi::dessiner (sf::RenderWindow& window, bool emphasize) const {
-	std::vector<pixel_t> pix =
-		this->matrice_pixels();
+	const std::vector<pixel_t>& pix = this->matrice_pixels();
 	vec_t v = a - b;
 	auto p = [&] (float s) { return b + v * s; };
+	// tous les pixels en un seul tableau de sommets, dessiné en un appel
 	if (epaisseur_affich.has_value()) {
 		vec_t perp = v.rotate_p90() / (!v) * (*epaisseur_affich);
+		sf::VertexArray rects (sf::Quads);
 		for (size_t k = 0; k < pix.size(); k++) {
 			auto color = sf::Color(pix[k].r, pix[k].g, pix[k].b);
 			vec_t lng = v * (pix[k].s2 - pix[k].s1);
-			sf::ConvexShape rect = sf::c01::buildParallelogram(p(pix[k].s1), lng, perp, color);
-			window.draw(rect);
+			sf::c01::appendParallelogram(rects, p(pix[k].s1), lng, perp, color);
 		}
+		window.draw(rects);
 	} else {
+		sf::VertexArray lignes (sf::Lines);
 		for (size_t k = 0; k < pix.size(); k++) {
 			if (pix[k].sat) { // saturation
 				auto c = sf::c01::buildCircleShapeCR(p(pix[k].s_mid), 0.003);
@@ -84,49 +147,72 @@ void EcranLigne_Multi::dessiner (sf::RenderWindow& window, bool emphasize) const
 				window.draw(c);
 			}
 			auto color = sf::Color(pix[k].r, pix[k].g, pix[k].b);
-			auto line = sf::c01::buildLine(p(pix[k].s1), p(pix[k].s2), color, color);
-			window.draw(line);
+			sf::c01::appendLine(lignes, p(pix[k].s1), p(pix[k].s2), color);
 		}
+		window.draw(lignes);
 	}
 }
+#endif
 
 ///------------------------ EcranLigne_Mono ------------------------///
 
 EcranLigne_Mono::EcranLigne_Mono (point_t a, point_t b, float lumino) :
 	Ecran_Base(lumino),
 	ObjetLigne(a, b),
-	intensit()
-	{ this->reset(); }
+	intensit(),
+	moments(1)
+	{ this->preparer_threads(1); this->reset(); }
 
 void EcranLigne_Mono::reset () {
 	n_acc = 0;
-	intensit.for_each([&] (float, pola_t, float& I) -> void {
-		I = 0;
-	});
+	intensit = Specte{};
+	moments[0] = moments_t{};
+	std::fill(intensit_threads.begin(), intensit_threads.end(), std::make_pair(Specte{}, 0u));
+	this->publier_instantane();
+}
+
+void EcranLigne_Mono::preparer_threads (size_t n_threads) {
+	intensit_threads.resize(std::max<size_t>(1, n_threads), std::make_pair(Specte{}, 0u));
 }
 
-// Accumulations des rayons sur l'écran
+void EcranLigne_Mono::fusion_threads () {
+	Specte sp_frame {};
+	uint32_t n_impacts = 0;
+	for (auto& [sp, n] : intensit_threads) {
+		sp_frame += sp;
+		n_impacts += n;
+		sp = Specte{};
+		n = 0;
+	}
+	intensit += sp_frame;
+	moments[0].ajouter_frame(sp_frame.intensite_tot(), n_impacts);
+}
+
+// Accumulations des rayons sur l'écran (dans l'accumulateur du thread courant)
 //
-std::vector<Rayon> EcranLigne_Mono::re_emit (const Rayon& ray, std::shared_ptr<void>) {
-	Specte::for_each_manual([&] (size_t i, float lambda, pola_t pol) -> void {
-		intensit.comps[i] += ray.spectre.comps[i];
-	});
-	return {};
+void EcranLigne_Mono::re_emit (const Rayon& ray, const intercept_struct_t&, std::vector<Rayon>& sortie) {
+	auto& [sp, n] = intensit_threads[PoolThreads::i_thread()];
+	sp += ray.spectre;
+	n++;
 }
 
-// Pixel traité
+// Pixel traité, publié pour l'affichage
 //
-EcranLigne_Mono::pixel_t EcranLigne_Mono::pixel () const {
-	float ItoL = this->luminosite / this->n_acc / !(b-a);
-	pixel_t pix;
+void EcranLigne_Mono::publier_instantane () {
+	float ItoL = (this->n_acc > 0) ? this->luminosite / this->n_acc / !(b-a) : 0;
+	pixel_t& pix = instantane.ecriture();
 	Specte sp = intensit;
-	sp.for_each([&] (float, pola_t, float& I) -> void {
-		I *= ItoL;
-	});
+	sp *= ItoL;
 	std::tie(pix.r, pix.g, pix.b, pix.sat) = sp.rgb256_noir_intensite(false);
-	return pix;
+	instantane.publier();
+}
+
+EcranLigne_Mono::pixel_t EcranLigne_Mono::pixel () const {
+	instantane.actualiser();
+	return instantane.lu();
 }
 
+#ifndef NOSFML
 // Dessin du pixel
 //
 void EcranLigne_Mono::dessiner (sf::RenderWindow& window, bool emphasize) const {
@@ -140,3 +226,4 @@ void EcranLigne_Mono::dessiner (sf::RenderWindow& window, bool emphasize) const
 	auto line = sf::c01::buildLine(a, b, color, color);
 	window.draw(line);
 }
+#endif
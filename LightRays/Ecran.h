@@ -8,7 +8,11 @@
 
 #include "ObjetsCourbes.h"
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
 #include "Rayon.h"
+#include "PoolThreads.h"
 
 //------------------------------------------------------------------------------
 // Classe de base virtuelle des écrans. Ne fait rien.
@@ -16,16 +20,40 @@
 class Ecran_Base : virtual public Objet {
 protected:
 	size_t n_acc; // nombre de frames accumulées
+	// fusion des accumulateurs privés des threads dans l'accumulateur principal (et remise à zéro de ceux-ci)
+	virtual void fusion_threads () = 0;
+	// publication de l'instantané lu par l'affichage (voir TamponTriple), à chaque `commit` et `reset`
+	virtual void publier_instantane () {}
 public:
 	float luminosite; // coefficient de conversion intensité réelle -> intensité affichée
 	
 	Ecran_Base (float lumino = 1.) : n_acc(0), luminosite(lumino) {}
 	virtual ~Ecran_Base () {}
 	
+	// Préparation des accumulateurs pour une propagation sur `n_threads` threads (voir Scene::propag_n_threads) :
+	//  chaque thread accumule dans son accumulateur privé, fusionné à chaque `commit` dans l'accumulateur
+	//  principal (sauf Objet_BilanEnergie, où le thread d'indice 0 accumule directement dans celui-ci)
+	virtual void preparer_threads (size_t n_threads) = 0;
 	// appellé à la fin de chaque frame
-	virtual void commit () { n_acc++; }
+	virtual void commit () { this->fusion_threads(); n_acc++; this->publier_instantane(); }
 	// réinitialisation de l'écran
 	virtual void reset () = 0;
+	
+	// Erreur relative de l'image accumulée : erreur standard des pixels, estimée à partir de la dispersion
+	//  des intensités reçues d'une frame à l'autre (frames indépendantes), rapportée à leur intensité moyenne
+	//  (en norme quadratique sur tous les pixels). Infinie avant 2 frames; nulle si l'écran n'en calcule pas.
+	virtual float erreur_relative () const { return 0; }
+	
+protected:
+	// Moments d'un pixel sur les frames : somme des intensités totales (Specte::intensite_tot) reçues par
+	//  frame, somme de leurs carrés, et nombre de rayons reçus
+	struct moments_t {
+		double s1 = 0, s2 = 0;
+		uint64_t n_impacts = 0;
+		void ajouter_frame (double I, uint64_t n) { s1 += I; s2 += I*I; n_impacts += n; }
+		double erreur_std2 (size_t n_frames) const; // carré de l'erreur standard de la moyenne s1/n_frames
+	};
+	static float erreur_relative (const std::vector<moments_t>& moments, size_t n_frames);
 };
 
 //------------------------------------------------------------------------------
@@ -34,6 +62,14 @@ public:
 class EcranLigne_Multi : virtual public Ecran_Base, virtual public ObjetLigne {
 protected:
 	std::vector<Specte> bins_intensit; // matrice de pixels; un spectre par pixel
+	std::vector<moments_t> bins_moments;
+	struct accum_thread_t {
+		std::vector<Specte> bins;
+		std::vector<uint32_t> n_impacts;
+	};
+	std::vector<accum_thread_t> accum_threads; // accumulateurs privés des threads, pour la frame en cours
+	virtual void fusion_threads () override;
+	virtual void publier_instantane () override;
 public:
 	std::optional<float> epaisseur_affich = std::nullopt; // épaisseur de l'écran affiché
 	
@@ -45,9 +81,11 @@ public:
 	virtual ~EcranLigne_Multi () {}
 	
 	// Absorption et accumulation des rayons; pas de ré-émission
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override;
 	// Réinitialisation de l'écran
 	virtual void reset () override;
+	virtual void preparer_threads (size_t n_threads) override;
+	virtual float erreur_relative () const override { return Ecran_Base::erreur_relative(bins_moments, n_acc); }
 	
 	// Récupération de la matrice de pixels RGB ou spectres :
 	struct pixel_t {
@@ -55,10 +93,19 @@ public:
 		uint8_t r, g, b; // valeurs RGB (les mêmes qu'affichées)
 		bool sat; // saturation du pixel
 		Specte spectre; // spectre accumulé sur le pixel
+		float erreur; // erreur standard de l'intensité totale du pixel (`spectre.intensite_tot()`)
+		uint64_t n_impacts; // nombre de rayons reçus
 	};
-	std::vector<pixel_t> matrice_pixels () const;
+	// Matrice de pixels au dernier `commit` (ou `reset`), lisible sans verrou pendant la propagation
+	//  de la frame suivante (un seul thread lecteur); valide jusqu'au prochain appel
+	const std::vector<pixel_t>& matrice_pixels () const;
+private:
+	mutable TamponTriple< std::vector<pixel_t> > instantane;
+public:
+#ifndef NOSFML
 	// Dessin de cette matrice de pixels
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const override;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -67,17 +114,29 @@ public:
 class EcranLigne_Mono : virtual public Ecran_Base, virtual public ObjetLigne {
 protected:
 	Specte intensit; // spectre accumulé
+	std::vector<moments_t> moments; // un seul élément
+	std::vector< std::pair<Specte,uint32_t> > intensit_threads; // accumulateurs privés des threads (spectre, nombre de rayons)
+	virtual void fusion_threads () override;
+	virtual void publier_instantane () override;
 public:
 	
 	EcranLigne_Mono (point_t pos_a, point_t pos_b, float lumino = 1.);
 	virtual ~EcranLigne_Mono () {}
 	
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override;
 	virtual void reset () override;
+	virtual void preparer_threads (size_t n_threads) override;
+	virtual float erreur_relative () const override { return Ecran_Base::erreur_relative(moments, n_acc); }
 	
 	struct pixel_t { uint8_t r, g, b; bool sat; };
+	// Pixel au dernier `commit` (ou `reset`), lisible sans verrou comme EcranLigne_Multi::matrice_pixels
 	pixel_t pixel () const;
+private:
+	mutable TamponTriple<pixel_t> instantane;
+public:
+#ifndef NOSFML
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const override;
+#endif
 };
 
 #endif
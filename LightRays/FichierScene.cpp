@@ -0,0 +1,326 @@
+#include "FichierScene.h"
+#include "ObjetsOptiques.h"
+#include "ObjetDiffusant.h"
+#include "ObjetMilieux.h"
+#include "Brouillard.h"
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+
+///------------------------ Lecture d'une ligne ------------------------///
+
+namespace {
+
+	// Nombre maximal de cellules par côté des grilles (fluence, brouillard)
+	constexpr long taille_grille_max = 4096;
+
+	// Découpage d'une ligne en mots et nombres, sans copie (strtof directement sur la ligne)
+	class LecteurLigne {
+		const char* p;
+		const std::string& nom;
+		size_t i_ligne;
+		void espaces () { while (*p == ' ' or *p == '\t' or *p == '\r') p++; }
+	public:
+		LecteurLigne (const std::string& ligne, const std::string& nom, size_t i_ligne) :
+			p(ligne.c_str()), nom(nom), i_ligne(i_ligne) { espaces(); }
+
+		[[noreturn]] void erreur (const std::string& msg) const {
+			throw std::runtime_error(nom + ":" + std::to_string(i_ligne) + " : " + msg);
+		}
+		// vrai si la ligne est terminée (ou si le reste est un commentaire)
+		bool fin () const { return *p == '\0' or *p == '#'; }
+		// mot suivant
+		std::string mot () {
+			if (fin()) erreur("mot attendu");
+			const char* deb = p;
+			while (*p != '\0' and *p != ' ' and *p != '\t' and *p != '\r' and *p != '#') p++;
+			std::string m (deb, p);
+			espaces();
+			return m;
+		}
+		// nombre suivant
+		float nombre () {
+			char* apres;
+			float x = strtof(p, &apres);
+			if (apres == p or fin()) erreur("nombre attendu");
+			p = apres;
+			espaces();
+			return x;
+		}
+		// nombre entier suivant, dans [min,max]
+		long entier (long min, long max) {
+			char* apres;
+			double x = strtod(p, &apres);
+			if (apres == p or fin()) erreur("entier attendu");
+			std::string texte (p, (const char*)apres);
+			if (x != floor(x)) erreur("entier attendu : " + texte);
+			if (x < min or x > max) erreur(texte + " hors de [" + std::to_string(min) + "," + std::to_string(max) + "]");
+			p = apres;
+			espaces();
+			return (long)x;
+		}
+		point_t point () { float x = nombre(); return point_t{ x, nombre() }; }
+		vec_t vecteur () { float x = nombre(); return vec_t{ x, nombre() }; }
+		void verifier_fin () const { if (not fin()) erreur("données en trop en fin de ligne"); }
+
+		// <spectre> : `blanc <I>` | `mono <couleur> <I>` | `poly <I_0> … <I_k>`
+		Specte spectre () {
+			std::string type = mot();
+			if (type == "blanc") {
+				Specte sp = spectre_blanc;
+				sp *= nombre();
+				return sp;
+			} else if (type == "mono") {
+				color_id_t couleur = (color_id_t)entier(0, N_COULEURS-1);
+				return Specte::monochromatique(nombre(), couleur);
+			} else if (type == "poly") {
+				std::vector<float> I;
+				while (not fin())
+					I.push_back(nombre());
+				if (I.empty()) erreur("spectre vide");
+				return Specte::polychromatique(I);
+			}
+			erreur("spectre inconnu : " + type);
+		}
+
+		// <brdf> : `lambert` | `phong <n>` | `oren_nayar <sigma>`
+		std::function<float(float,float)> brdf () {
+			std::string type = mot();
+			if (type == "lambert") {
+				return ObjetCourbe_Diffusant::BRDF_Lambert;
+			} else if (type == "phong") {
+				// lobe π.cos^n(θi+θr)/c, avec c = ∫ cos^n sur [-π/2,π/2] pour conserver l'énergie
+				float n = nombre();
+				float c = sqrtf(M_PI) * tgammaf((n+1)/2) / tgammaf(n/2+1);
+				return [n,c] (float theta_i, float theta_r) -> float {
+					return M_PI * powf( std::max(0.f, cosf(theta_i+theta_r)), n) / c;
+				};
+			} else if (type == "oren_nayar") {
+				return ObjetCourbe_Diffusant::BRDF_Oren_Nayar(nombre());
+			}
+			erreur("BRDF inconnue : " + type);
+		}
+
+		// [<méthode>] : `alea` | `equirep` | `monte_carlo`, `alea` si absent
+		ObjetCourbe_Diffusant::diffus_methode_t methode_diffusion () {
+			if (fin())
+				return ObjetCourbe_Diffusant::AleaUnif;
+			std::string type = mot();
+			if (type == "alea") return ObjetCourbe_Diffusant::AleaUnif;
+			if (type == "equirep") return ObjetCourbe_Diffusant::Equirep;
+			if (type == "monte_carlo") return ObjetCourbe_Diffusant::MonteCarlo;
+			erreur("méthode de diffusion inconnue : " + type);
+		}
+
+		// <indice> : `<n>` | `<n0> <k> [alea]`
+		std::function<float(float)> indice_dispersif (float& n_fixe, bool& dispersion_alea) {
+			n_fixe = nombre();
+			dispersion_alea = false;
+			if (fin())
+				return nullptr;
+			float n0 = n_fixe, k = nombre();
+			if (not fin()) {
+				std::string m = mot();
+				if (m != "alea") erreur("`alea` attendu : " + m);
+				dispersion_alea = true;
+			}
+			return [n0,k] (float lambda) -> float { return n0 + k * lambda / lambda_color[N_COULEURS/2]; };
+		}
+	};
+
+	// Création d'un objet d'indice fixe ou dispersif selon `<indice>` en fin de ligne
+	template <class ObjT, typename... Args>
+	void creer_objet_milieu (Scene& scene, LecteurLigne& l, Args&&... x) {
+		float n_fixe;
+		bool dispersion_alea;
+		std::function<float(float)> n_lambda = l.indice_dispersif(n_fixe, dispersion_alea);
+		if (n_lambda)
+			scene.creer_objet<ObjT>(n_lambda, x...)->dispersion_alea = dispersion_alea;
+		else
+			scene.creer_objet<ObjT>(n_fixe, x...);
+	}
+
+}
+
+///------------------------ Chargement ------------------------///
+
+void scene_charger (std::istream& flux, Scene& scene, const std::string& nom) {
+	std::string ligne;
+	size_t i_ligne = 0;
+
+	while (std::getline(flux, ligne)) {
+		i_ligne++;
+		LecteurLigne l (ligne, nom, i_ligne);
+		if (l.fin())
+			continue;
+		std::string type = l.mot();
+
+		/// Paramètres de propagation
+		if (type == "coupure") {
+			scene.intens_cutoff = l.nombre();
+		}
+		else if (type == "profmax") {
+			scene.propag_profondeur_recur_max = (uint16_t)l.entier(0, UINT16_MAX);
+		}
+		else if (type == "roulette") {
+			scene.propag_roulette = l.nombre() != 0;
+		}
+		else if (type == "fluence") {
+			point_t o = l.point();
+			float reso = l.nombre();
+			size_t lx = l.entier(1, taille_grille_max), ly = l.entier(1, taille_grille_max);
+			if (reso <= 0) l.erreur("fluence : résolution invalide");
+			scene.fluence = std::make_shared<CarteFluence>(o, reso, lx, ly);
+		}
+
+		/// Sources
+		else if (type == "source_rayon") {
+			point_t pos = l.point();
+			float dir = l.nombre();
+			scene.sources.push_back(std::make_shared<Source_UniqueRayon>(pos, dir, l.spectre()));
+		}
+		else if (type == "source_omni") {
+			point_t pos = l.point();
+			float ang_ext = l.nombre(), ang_base = l.nombre(), dens = l.nombre();
+			auto source = std::make_shared<Source_PonctOmni>(pos, l.spectre());
+			source->secteur = angle_interv_t(-ang_ext,+ang_ext) + ang_base;
+			source->dens_ang = dens;
+			source->dir_alea = true;
+			scene.sources.push_back(source);
+		}
+		else if (type == "source_paralleles") {
+			point_t a = l.point();
+			vec_t v = l.vecteur();
+			float dir = l.nombre(), dens = l.nombre();
+			auto source = std::make_shared<Source_LinParallels>(a, v, dir, l.spectre());
+			source->dens_lin = dens;
+			scene.sources.push_back(source);
+		}
+		else if (type == "source_lambert") {
+			point_t a = l.point();
+			vec_t v = l.vecteur();
+			float dens = l.nombre();
+			auto source = std::make_shared<Source_LinLambertien>(a, v, l.spectre());
+			source->dens_lin = dens;
+			scene.sources.push_back(source);
+		}
+
+		/// Écrans
+		else if (type == "ecran") {
+			point_t a = l.point(), b = l.point();
+			uint16_t n_pix = (uint16_t)l.entier(1, UINT16_MAX);
+			float lumino = l.nombre();
+			auto ecran = scene.creer_objet<EcranLigne_Multi>(a, b, n_pix, lumino);
+			if (not l.fin())
+				ecran->epaisseur_affich = l.nombre();
+		}
+		else if (type == "ecran_mono") {
+			point_t a = l.point(), b = l.point();
+			scene.creer_objet<EcranLigne_Mono>(a, b, l.nombre());
+		}
+		else if (type == "bilan") {
+			point_t c = l.point();
+			scene.creer_objet<Objet_BilanEnergie>(c, l.nombre());
+		}
+
+		/// Objets optiques
+		else if (type == "bloqueur") {
+			point_t a = l.point(), b = l.point();
+			scene.creer_objet<Objet_Bloqueur>(a, b);
+		}
+		else if (type == "miroir") {
+			point_t a = l.point(), b = l.point();
+			scene.creer_objet<ObjetLigne_Miroir>(a, b);
+		}
+		else if (type == "miroir_arc") {
+			point_t c = l.point();
+			float R = l.nombre(), ang_deb = l.nombre(), ang_fin = l.nombre();
+			scene.creer_objet<ObjetArc_Miroir>(c, R, angle_interv_t(ang_deb, ang_fin), false);
+		}
+		else if (type == "filtre") {
+			point_t a = l.point(), b = l.point();
+			scene.creer_objet<Objet_Filtre>(l.spectre(), a, b);
+		}
+		else if (type == "lentille") {
+			point_t c = l.point();
+			float diam = l.nombre(), ang = l.nombre(), f = l.nombre();
+			scene.creer_objet<Objet_MatriceTrsfUnidir>(c, diam, ang, Objet_MatriceTrsfUnidir::mat_trsf_lentille(f));
+		}
+		else if (type == "diffusant") {
+			point_t a = l.point(), b = l.point();
+			float n_re_emit = l.nombre();
+			auto obj = scene.creer_objet<ObjetLigne_Diffusant>(l.brdf(), a, b);
+			obj->n_re_emit_par_intens = n_re_emit;
+			obj->diff_met = l.methode_diffusion();
+		}
+		else if (type == "diffusant_arc") {
+			point_t c = l.point();
+			float R = l.nombre(), ang_deb = l.nombre(), ang_fin = l.nombre(), n_re_emit = l.nombre();
+			auto obj = scene.creer_objet<ObjetArc_Diffusant>(l.brdf(), c, R, angle_interv_t(ang_deb, ang_fin), false);
+			obj->n_re_emit_par_intens = n_re_emit;
+			obj->diff_met = l.methode_diffusion();
+		}
+		else if (type == "milieu") {
+			point_t a = l.point(), b = l.point();
+			creer_objet_milieu<ObjetLigne_Milieux>(scene, l, a, b);
+		}
+		else if (type == "milieu_arc") {
+			point_t a = l.point(), b = l.point();
+			float R = l.nombre();
+			bool inv_int = l.nombre() != 0;
+			creer_objet_milieu<ObjetArc_Milieux>(scene, l, a, b, R, inv_int);
+		}
+		else if (type == "polygone_milieu") {
+			size_t N = l.entier(3, UINT16_MAX);
+			std::vector<point_t> pts (N);
+			for (point_t& p : pts)
+				p = l.point();
+			float n_fixe;
+			bool dispersion_alea;
+			std::function<float(float)> n_lambda = l.indice_dispersif(n_fixe, dispersion_alea);
+			if (n_lambda)
+				scene.creer_objet<ObjetComposite_LignesMilieu>(pts, n_lambda)->dispersion_alea(dispersion_alea);
+			else
+				scene.creer_objet<ObjetComposite_LignesMilieu>(pts, n_fixe);
+		}
+
+		/// Brouillard : en-tête puis grille de densités
+		else if (type == "brouillard") {
+			point_t o = l.point();
+			float reso = l.nombre();
+			uint lx = l.entier(1, taille_grille_max), ly = l.entier(1, taille_grille_max);
+			float n_re_emit = l.nombre(), cutoff = l.nombre();
+			l.verifier_fin();
+			if (reso <= 0) l.erreur("brouillard : résolution invalide");
+			std::vector<float> densit (lx * ly);
+			for (uint y = 0; y < ly; y++) {
+				if (not std::getline(flux, ligne))
+					l.erreur("brouillard : grille de densités incomplète");
+				i_ligne++;
+				LecteurLigne ld (ligne, nom, i_ligne);
+				for (uint x = 0; x < lx; x++)
+					densit[y*lx + x] = ld.nombre();
+				ld.verifier_fin();
+			}
+			auto brouillard = scene.creer_objet<Objet_Brouillard>(o, reso, reso, lx, ly,
+				[densit = std::move(densit), lx] (size_t x, size_t y) -> float { return densit[y*lx + x]; });
+			brouillard->n_re_emit_par_intens = n_re_emit;
+			brouillard->intens_cutoff = cutoff;
+			continue;
+		}
+
+		else
+			l.erreur("directive inconnue : " + type);
+
+		l.verifier_fin();
+	}
+}
+
+void scene_charger_fichier (const std::string& chemin, Scene& scene) {
+	std::ifstream flux (chemin);
+	if (not flux)
+		throw std::runtime_error("Impossible d'ouvrir " + chemin);
+	scene_charger(flux, scene, chemin);
+}
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * Chargement d'une scène décrite dans un fichier texte : objets, sources,
+ *  écrans, BRDF, indices de réfraction et grilles de brouillard, créés dans
+ *  une `Scene` existante. Lecture en flux, ligne par ligne.
+ *******************************************************************************/
+
+// Format : une directive par ligne, `#` commence un commentaire, lignes vides ignorées.
+// Les nombres sont des flottants (angles en radians), séparés par des espaces ; les nombres entiers
+//  (<n>, <lx>, <ly>, <n_pixels>, <N>, <couleur>) sont vérifiés, les grilles étant limitées à 4096 cellules par côté.
+//
+//   coupure <I>                                        Scene::intens_cutoff
+//   profmax <n>                                        Scene::propag_profondeur_recur_max
+//   roulette <0|1>                                     Scene::propag_roulette
+//   fluence <ox> <oy> <reso> <lx> <ly>                 Scene::fluence (carte de lx×ly cellules de côté reso)
+//
+//   source_rayon <x> <y> <dir> <spectre>
+//   source_omni <x> <y> <ang_ext> <ang_base> <dens_ang> <spectre>
+//   source_paralleles <ax> <ay> <vx> <vy> <dir> <dens_lin> <spectre>
+//   source_lambert <ax> <ay> <vx> <vy> <dens_lin> <spectre>
+//
+//   ecran <ax> <ay> <bx> <by> <n_pixels> <lumino> [<épaisseur affichée>]
+//   ecran_mono <ax> <ay> <bx> <by> <lumino>
+//   bilan <cx> <cy> <R>
+//
+//   bloqueur <ax> <ay> <bx> <by>
+//   miroir <ax> <ay> <bx> <by>
+//   miroir_arc <cx> <cy> <R> <ang_deb> <ang_fin>
+//   filtre <ax> <ay> <bx> <by> <spectre de transmission>
+//   lentille <cx> <cy> <diam> <ang_vertical> <f>               Objet_MatriceTrsfUnidir
+//   diffusant <ax> <ay> <bx> <by> <n_re_emit> <brdf> [<méthode>]
+//   diffusant_arc <cx> <cy> <R> <ang_deb> <ang_fin> <n_re_emit> <brdf> [<méthode>]
+//   milieu <ax> <ay> <bx> <by> <indice>
+//   milieu_arc <ax> <ay> <bx> <by> <R> <inv_int 0|1> <indice>
+//   polygone_milieu <N> <x1> <y1> … <xN> <yN> <indice>
+//   brouillard <ox> <oy> <reso> <lx> <ly> <n_re_emit> <coupure>
+//       suivi de <ly> lignes de <lx> densités (de y=0 à y=ly-1)
+//
+// avec, en fin de ligne :
+//   <spectre> : `blanc <I>` | `mono <couleur> <I>` | `poly <I_0> … <I_k>` (voir Specte::polychromatique)
+//   <brdf>    : `lambert` | `phong <n>` (lobe en cos^n normalisé) | `oren_nayar <sigma>` (rugosité, radians)
+//   <méthode> : `alea` (défaut) | `equirep` | `monte_carlo` (voir ObjetCourbe_Diffusant::diffus_methode_t)
+//   <indice>  : `<n>` (fixe) | `<n0> <k> [alea]` (dispersif, n(λ) = n0 + k·λ/λ_milieu; `alea` : une couleur
+//               tirée par rayon réfracté, voir ObjetCourbe_Milieux::dispersion_alea)
+
+#ifndef _LIGHTRAYS_FICHIER_SCENE_H_
+#define _LIGHTRAYS_FICHIER_SCENE_H_
+
+#include "Scene.h"
+#include <istream>
+#include <string>
+
+// Lecture de la description de scène `flux` et ajout des objets et sources à `scene`.
+// Lance std::runtime_error ("<nom>:<ligne> : message") en cas d'erreur de syntaxe ou de valeur hors limites.
+void scene_charger (std::istream& flux, Scene& scene, const std::string& nom = "scène");
+
+// Idem à partir du fichier `chemin`
+void scene_charger_fichier (const std::string& chemin, Scene& scene);
+
+#endif
@@ -0,0 +1,130 @@
+#include "Fluence.h"
+#include "PoolThreads.h"
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <sys/types.h>
+
+CarteFluence::CarteFluence (point_t o, float reso, size_t lx, size_t ly) :
+	accum(lx * ly, 0), n_acc(0), o(o), reso(reso), lx(lx), ly(ly)
+	{ this->preparer_threads(1); }
+
+void CarteFluence::preparer_threads (size_t n_threads) {
+	accum_threads.resize(std::max<size_t>(1, n_threads), std::vector<float>(lx * ly, 0));
+}
+
+void CarteFluence::commit () {
+	for (std::vector<float>& acc : accum_threads) {
+		for (size_t i = 0; i < accum.size(); i++)
+			accum[i] += acc[i];
+		std::fill(acc.begin(), acc.end(), 0);
+	}
+	n_acc++;
+}
+
+void CarteFluence::reset () {
+	n_acc = 0;
+	std::fill(accum.begin(), accum.end(), 0);
+	for (std::vector<float>& acc : accum_threads)
+		std::fill(acc.begin(), acc.end(), 0);
+}
+
+// Découpage du segment au rectangle de la grille (Liang-Barsky), puis parcours des cellules
+//  traversées (Amanatides-Woo) : chaque cellule reçoit I × longueur du segment dans la cellule
+//
+void CarteFluence::ajouter_segment (point_t a, point_t b, float I) {
+	// en coordonnées de grille (une unité par cellule), paramètre t ∈ [0,1] sur le segment
+	float x0 = (a.x - o.x) / reso, y0 = (a.y - o.y) / reso;
+	float dx = (b.x - a.x) / reso, dy = (b.y - a.y) / reso;
+	float t0 = 0, t1 = 1;
+	auto decoupe = [&] (float p, float q) -> bool { // contrainte p.t ≤ q
+		if (p == 0)
+			return q >= 0;
+		float r = q / p;
+		if (p < 0) t0 = std::max(t0, r);
+		else       t1 = std::min(t1, r);
+		return t0 < t1;
+	};
+	if (not (decoupe(-dx, x0) and decoupe(dx, lx - x0) and decoupe(-dy, y0) and decoupe(dy, ly - y0)))
+		return;
+
+	std::vector<float>& acc = accum_threads[PoolThreads::i_thread()];
+	float poids = I * !(b - a); // intensité × longueur du segment entier, par unité de t
+	float xe = x0 + t0 * dx, ye = y0 + t0 * dy;
+	ssize_t ix = std::clamp<ssize_t>(floorf(xe), 0, lx-1),
+	        iy = std::clamp<ssize_t>(floorf(ye), 0, ly-1);
+	ssize_t pas_x = (dx > 0) ? 1 : -1, pas_y = (dy > 0) ? 1 : -1;
+	float dt_x = (dx != 0) ? fabsf(1 / dx) : Inf,
+	      dt_y = (dy != 0) ? fabsf(1 / dy) : Inf;
+	float t_x = (dx > 0) ? (ix + 1 - x0) / dx : (dx < 0) ? (ix - x0) / dx : Inf,
+	      t_y = (dy > 0) ? (iy + 1 - y0) / dy : (dy < 0) ? (iy - y0) / dy : Inf;
+	float t = t0;
+	while (true) {
+		float t_suiv = std::min({ t_x, t_y, t1 });
+		acc[iy*lx + ix] += poids * (t_suiv - t);
+		if (t_suiv >= t1)
+			break;
+		t = t_suiv;
+		if (t_x < t_y) {
+			ix += pas_x; t_x += dt_x;
+			if (ix < 0 or ix >= (ssize_t)lx) break;
+		} else {
+			iy += pas_y; t_y += dt_y;
+			if (iy < 0 or iy >= (ssize_t)ly) break;
+		}
+	}
+}
+
+float CarteFluence::fluence (size_t x, size_t y) const {
+	return (n_acc > 0) ? accum[y*lx + x] / (reso * reso * n_acc) : 0;
+}
+
+std::vector<float> CarteFluence::carte () const {
+	std::vector<float> c (lx * ly);
+	for (size_t y = 0; y < ly; y++)
+		for (size_t x = 0; x < lx; x++)
+			c[y*lx + x] = this->fluence(x, y);
+	return c;
+}
+
+///------------------------ Enregistrement ------------------------///
+
+// PFM niveaux de gris : en-tête texte, puis flottants 32 bits petit-boutistes (échelle négative),
+//  la première ligne étant celle du bas (y = 0)
+//
+void CarteFluence::enregistrer_pfm (const std::string& chemin) const {
+	std::ofstream f (chemin, std::ios::binary);
+	if (not f)
+		throw std::runtime_error("Impossible d'écrire " + chemin);
+	f << "Pf\n" << lx << " " << ly << "\n-1.0\n";
+	std::vector<float> c = this->carte();
+	f.write(reinterpret_cast<const char*>(c.data()), c.size() * sizeof(float));
+}
+
+// PGM binaire 8 bits, première ligne en haut
+//
+void CarteFluence::enregistrer_pgm (const std::string& chemin, float blanc) const {
+	std::ofstream f (chemin, std::ios::binary);
+	if (not f)
+		throw std::runtime_error("Impossible d'écrire " + chemin);
+	std::vector<float> c = this->carte();
+	if (blanc <= 0) {
+		std::vector<float> eclairees;
+		for (float v : c)
+			if (v > 0) eclairees.push_back(v);
+		if (not eclairees.empty()) {
+			auto it = eclairees.begin() + (eclairees.size() - 1) * 99 / 100;
+			std::nth_element(eclairees.begin(), it, eclairees.end());
+			blanc = *it;
+		} else
+			blanc = 1;
+	}
+	f << "P5\n" << lx << " " << ly << "\n255\n";
+	std::vector<uint8_t> ligne (lx);
+	for (size_t y = ly; y-- > 0; ) {
+		for (size_t x = 0; x < lx; x++)
+			ligne[x] = (uint8_t)std::min(255.f, 255 * c[y*lx + x] / blanc);
+		f.write(reinterpret_cast<const char*>(ligne.data()), lx);
+	}
+}
@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * Carte de fluence : répartition de la lumière dans toute la scène, accumulée
+ *  sur une grille à partir des segments parcourus par les rayons.
+ *******************************************************************************/
+
+#ifndef _LIGHTRAYS_FLUENCE_H_
+#define _LIGHTRAYS_FLUENCE_H_
+
+#include "Util.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+//------------------------------------------------------------------------------
+// Grille de `lx`×`ly` cellules carrées de côté `reso`, d'origine (coin inférieur
+//  gauche) `o`. Chaque segment de rayon propagé (de son origine à son point
+//  d'interception, voir Scene::fluence) ajoute à chaque cellule traversée son
+//  intensité multipliée par la longueur parcourue dans la cellule (estimateur
+//  « longueur de trajet », exact et sans bruit d'échantillonnage spatial).
+// Divisée par la surface d'une cellule et le nombre de frames, c'est la fluence
+//  par frame (intensité × longueur / surface). Accumulée comme un écran :
+//  accumulateurs par thread, fusionnés à chaque `commit`, `reset`.
+
+class CarteFluence {
+private:
+	std::vector<float> accum; // somme sur les frames, cellule (x,y) à l'indice y*lx+x
+	std::vector< std::vector<float> > accum_threads; // accumulateurs privés des threads, pour la frame en cours
+	size_t n_acc; // nombre de frames accumulées
+
+public:
+	const point_t o;
+	const float reso;
+	const size_t lx, ly;
+
+	CarteFluence (point_t o, float reso, size_t lx, size_t ly);
+
+	// Préparation des accumulateurs pour une propagation sur `n_threads` threads (voir Ecran_Base::preparer_threads)
+	void preparer_threads (size_t n_threads);
+	// Ajout d'un segment [a,b] d'intensité `I` dans l'accumulateur du thread courant (parcours exact des
+	//  cellules, comme Objet_Brouillard); la partie du segment hors de la grille est ignorée
+	void ajouter_segment (point_t a, point_t b, float I);
+	// Fin de frame : fusion des accumulateurs des threads
+	void commit ();
+	void reset ();
+
+	size_t n_frames () const { return n_acc; }
+	// Fluence moyenne par frame de la cellule (x,y), et de toute la grille (même indexation que `accum`)
+	float fluence (size_t x, size_t y) const;
+	std::vector<float> carte () const;
+
+	// Enregistrement de `carte()` : en flottants bruts au format PFM (niveaux de gris, lignes de bas en haut),
+	//  ou en image PGM 8 bits, blanc pour une fluence ≥ `blanc` (si `blanc` ≤ 0 : centile 99 des cellules éclairées).
+	// Lancent std::runtime_error si le fichier ne peut être écrit.
+	void enregistrer_pfm (const std::string& chemin) const;
+	void enregistrer_pgm (const std::string& chemin, float blanc = 0) const;
+};
+
+#endif
@@ -10,9 +10,49 @@
 #include "Rayon.h"
 #include "Util.h"
 #include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <cstring>
+#include <type_traits>
+#ifndef NOSFML
 #include <SFML/Graphics/RenderWindow.hpp>
-// Note : tous les std::optional<std::shared_ptr<T>> pourraient être remplacés par des T* (null ou pas),
-//        mais il faudrait gérer la désallocation à la main
+#endif
+
+//------------------------------------------------------------------------------
+// Structure d'interception opaque de taille fixe (au plus `N` octets), stockée
+//  par valeur : ni allocation ni compteur de références lors des tests d'interception.
+// L'objet y construit sa propre structure (trivialement copiable) avec `creer<T>`,
+//  et la relit avec `get<T>` lors de la ré-émission. Vide = pas d'interception.
+
+template <size_t N>
+class InterceptStruct {
+	alignas(8) unsigned char donnees [N];
+	bool plein = false;
+	template <size_t M> friend class InterceptStruct;
+public:
+	InterceptStruct () = default;
+	InterceptStruct (std::nullptr_t) {}
+	// Copie d'une structure plus petite (typiquement, structure d'une sous-courbe d'un objet composite)
+	template <size_t M>
+	InterceptStruct (const InterceptStruct<M>& o) : plein(o.plein) {
+		static_assert(M <= N, "structure d'interception trop grande");
+		std::memcpy(donnees, o.donnees, M);
+	}
+	
+	template <typename T>
+	T& creer (const T& val) {
+		static_assert(sizeof(T) <= N and alignof(T) <= 8, "structure d'interception trop grande");
+		static_assert(std::is_trivially_copyable<T>::value, "structure d'interception non trivialement copiable");
+		plein = true;
+		return *new (donnees) T (val);
+	}
+	template <typename T>
+	const T& get () const { return *std::launder(reinterpret_cast<const T*>(donnees)); }
+	
+	explicit operator bool () const { return plein; }
+};
 
 //------------------------------------------------------------------------------
 // Classe de base des objets optiques. Déclare l'interface commune utilisée lors
@@ -30,15 +70,37 @@ public:
 	Objet (const Objet&) = default;
 	virtual ~Objet () {}
 	
-	// L'objet intercepte-t-il le rayon ? Si oui, donne la distance géométrique au carré
-	//  `dist2` parcourue par le rayon depuis son point d'émission, et renvoie une structure
-	//  interne à utiliser éventuellement pour la ré-émission du même rayon.
-	// Si non, `intercept_struct` est nul et `dist2 = Inf`
-	// Attention, la création de std::shared_ptr<void> est délicate (https://stackoverflow.com/questions/25858939/is-there-a-way-to-cast-shared-ptrvoid-to-shared-ptrt/25858963 et voir ObjetCourbe::essai_intercept)
-	struct intercept_t { float dist2; std::shared_ptr<void> intercept_struct; };
+	// L'objet intercepte-t-il le rayon ? Si oui, donne le paramètre `t` du point d'interception
+	//  `ray.orig + t * ray.dir` (distance parcourue par le rayon depuis son point d'émission, la
+	//  direction étant unitaire), et renvoie une structure interne à utiliser éventuellement pour
+	//  la ré-émission du même rayon.
+	// Si non, `intercept_struct` est vide et `t = Inf`
+	using intercept_struct_t = InterceptStruct<64>;
+	struct intercept_t { float t; intercept_struct_t intercept_struct; };
 	virtual intercept_t essai_intercept (const Rayon& ray) const = 0;
 	// Point d'interception. Aucune garantie, non défini par défaut.
-	virtual std::optional<point_t> point_interception (std::shared_ptr<void> intercept_struct) const { return std::nullopt; }
+	virtual std::optional<point_t> point_interception (const intercept_struct_t& intercept_struct) const { return std::nullopt; }
+	
+	// Test d'interception d'un lot de rayons : pour chaque rayon `k = i_rayons[j]` du lot, si l'objet
+	//  intercepte le rayon plus près que `res.t[k]`, met à jour `res` avec l'interception par l'objet
+	//  d'indice `i_objet`. Les objets sont testés par indice croissant, donc à distance égale, l'interception
+	//  déjà présente est conservée. Par défaut, appelle simplement `essai_intercept` pour chaque rayon.
+	// Un objet peut implémenter un test vectorisé sur le lot et ne pas construire la structure d'interception
+	//  (`res.intercept_struct[k]` vide), qui est alors construite, pour le seul objet retenu, par
+	//  `intercept_lot_struct` à partir des paramètres `res.params[k]` qu'il a enregistrés.
+	// Les courbes utilisent les deux premiers paramètres, le troisième étant réservé à l'indice de la
+	//  sous-courbe dans un `ObjetComposite`. Un objet sans test par lots (Objet_Brouillard) reste testé
+	//  rayon par rayon.
+	using params_lot_t = std::array<float,3>;
+	struct intercept_lot_t {
+		std::vector<float> t;
+		std::vector<uint32_t> i_objet;
+		std::vector<intercept_struct_t> intercept_struct;
+		std::vector<params_lot_t> params;
+		void initialiser (size_t n);
+	};
+	virtual void essai_intercept_lot (const LotRayons& lot, const std::vector<uint32_t>& i_rayons, uint32_t i_objet, intercept_lot_t& res) const;
+	virtual intercept_struct_t intercept_lot_struct (const Rayon& ray, params_lot_t params) const { return nullptr; }
 	
 	// Extension spatiale approximative pessimiste de l'objet à fin d'optimisation
 	//  (ne pas avoir à appeller un coûteux `essai_intercept(ray)` lorsque qu'on est
@@ -46,13 +108,39 @@ public:
 	struct extension_t { point_t pos; float rayon; };
 	virtual extension_t objet_extension () const = 0;
 	
-	// Ré-émission du rayon, devant utiliser la structure `.intercept_struct` renvoyée par `essai_intercept(ray)`
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) = 0;
+	// Appelé par la scène au début de chaque propagation, avant la répartition sur les threads :
+	//  mise à jour des données dérivées des paramètres de l'objet (qui ont pu changer entre deux frames)
+	virtual void pre_propagation () {}
+	
+	// Ré-émission du rayon, devant utiliser la structure `.intercept_struct` renvoyée par `essai_intercept(ray)`.
+	// Les rayons ré-émis sont ajoutés à la fin de `sortie`, tampon de l'appelant dont la mémoire est
+	//  réutilisée d'une interception à l'autre (pas d'allocation par interception)
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) = 0;
 	
+#ifndef NOSFML
 	// Rendu graphique de l'objet
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const = 0;
 	// Rendu graphique de l'interception d'un rayon (voir re_emit)
-	virtual void dessiner_interception (sf::RenderWindow& window, const Rayon& ray, std::shared_ptr<void> intercept) const = 0;
+	virtual void dessiner_interception (sf::RenderWindow& window, const Rayon& ray, const intercept_struct_t& intercept) const = 0;
+#endif
 };
 
+inline void Objet::intercept_lot_t::initialiser (size_t n) {
+	t.assign(n, Inf);
+	i_objet.assign(n, UINT32_MAX);
+	intercept_struct.assign(n, nullptr);
+	params.resize(n);
+}
+
+inline void Objet::essai_intercept_lot (const LotRayons& lot, const std::vector<uint32_t>& i_rayons, uint32_t i_obj, intercept_lot_t& res) const {
+	for (uint32_t k : i_rayons) {
+		intercept_t intercept = this->essai_intercept(lot.rayon(k));
+		if (intercept.t < res.t[k]) {
+			res.t[k] = intercept.t;
+			res.i_objet[k] = i_obj;
+			res.intercept_struct[k] = intercept.intercept_struct;
+		}
+	}
+}
+
 #endif
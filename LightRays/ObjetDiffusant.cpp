@@ -1,18 +1,103 @@
 #include "ObjetDiffusant.h"
 #include <cmath>
+#include <algorithm>
 
 decltype(ObjetCourbe_Diffusant::BRDF) ObjetCourbe_Diffusant::BRDF_Lambert = [] (float theta_i, float theta_r) -> float {
 	return 1;
 };
 
+// Oren-Nayar (modèle qualitatif) dans le plan : l'azimut relatif des rayons incident et réfléchi vaut 0
+//  lorsque le rayon est renvoyé du côté de la source (θi et θr de même signe), π sinon.
+//  Normalisé comme `BRDF_Lambert` (identique pour sigma = 0).
+//
+decltype(ObjetCourbe_Diffusant::BRDF) ObjetCourbe_Diffusant::BRDF_Oren_Nayar (float sigma) {
+	float s2 = sigma * sigma;
+	float A = 1 - 0.5f * s2 / (s2 + 0.33f),
+	      B = 0.45f * s2 / (s2 + 0.09f);
+	return [A,B] (float theta_i, float theta_r) -> float {
+		if (theta_i * theta_r <= 0)
+			return A;
+		float alpha = std::max(fabsf(theta_i), fabsf(theta_r)),
+		      beta = std::min(fabsf(theta_i), fabsf(theta_r));
+		return A + B * sinf(alpha) * tanf(beta);
+	};
+}
+
+// Tabulation de la BRDF, puis tables de fonction de répartition inverse pour diffus_methode_t::MonteCarlo :
+//  pour chaque θi, la BRDF est échantillonnée au milieu de `n_r` intervalles de θr (densité constante par
+//  intervalle), puis la répartition cumulée est inversée aux points u = m/tables_n_u
+//
+void ObjetCourbe_Diffusant::construire_tables () {
+	if (not BRDF_lambda) {
+		tables_BRDF.resize(1);
+		tables_BRDF[0].tabuler(-M_PI/2, M_PI/2, tables_n_brdf, BRDF);
+	} else {
+		tables_BRDF.resize(N_COULEURS + 1);
+		for (color_id_t c = 0; c < N_COULEURS; c++)
+			tables_BRDF[c].tabuler(-M_PI/2, M_PI/2, tables_n_brdf, [&] (float theta_i, float theta_r) {
+				return BRDF_lambda(theta_i, theta_r, lambda_color[c]);
+			});
+		tables_BRDF[N_COULEURS].tabuler(-M_PI/2, M_PI/2, tables_n_brdf, [&] (float theta_i, float theta_r) {
+			float f = 0;
+			for (color_id_t c = 0; c < N_COULEURS; c++)
+				f += tables_BRDF[c](theta_i, theta_r);
+			return f / N_COULEURS;
+		});
+	}
+	
+	const size_t n_r = 2 * tables_n_u;
+	const float d_theta = M_PI / n_r;
+	std::vector<float> f (n_r), repart (n_r + 1);
+	table_repart_inv.resize(tables_n_incid * (tables_n_u+1));
+	table_norme.resize(tables_n_incid);
+	for (size_t i = 0; i < tables_n_incid; i++) {
+		float theta_i = -M_PI/2 + M_PI * (i + 0.5f) / tables_n_incid;
+		repart[0] = 0;
+		for (size_t j = 0; j < n_r; j++) {
+			f[j] = std::max(0.f, BRDF_moyenne(theta_i, -M_PI/2 + d_theta * (j + 0.5f)));
+			repart[j+1] = repart[j] + f[j] * d_theta;
+		}
+		float Z = repart[n_r];
+		table_norme[i] = Z / M_PI;
+		float* inv = &table_repart_inv[i * (tables_n_u+1)];
+		size_t j = 0;
+		for (size_t m = 0; m <= tables_n_u; m++) {
+			if (Z <= 0) { // BRDF nulle : aucun rayon ré-émis ne portera d'intensité
+				inv[m] = -M_PI/2 + M_PI * m / tables_n_u;
+				continue;
+			}
+			float c = Z * m / tables_n_u;
+			while (j < n_r-1 and repart[j+1] < c)
+				j++;
+			float frac = (f[j] > 0) ? std::clamp((c - repart[j]) / (f[j] * d_theta), 0.f, 1.f) : 0;
+			inv[m] = -M_PI/2 + d_theta * (j + frac);
+		}
+	}
+	tables_a_jour = true;
+}
+
+void ObjetCourbe_Diffusant::pre_propagation () {
+	if (not tables_a_jour)
+		construire_tables();
+}
+
 // Diffusion du rayon incident
 //
-std::vector<Rayon> ObjetCourbe_Diffusant::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	intercept_courbe_t& intercept = *(intercept_courbe_t*)interception.get();
-	std::vector<Rayon> rayons;
+void ObjetCourbe_Diffusant::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_courbe_t& intercept = interception.get<intercept_courbe_t>();
 	
 	// nombre de rayons ré-émis selon l'intensité du rayon incident
 	size_t n_re_emit = std::max<size_t>(1, lroundf(n_re_emit_par_intens * ray.spectre.intensite_tot()));
+	// angle d'incidence, commun à tous les rayons ré-émis
+	float ang_incid = intercept.ang_incid(ray.dir);
+	// table de tirage correspondant à l'angle d'incidence
+	const float* repart_inv = nullptr;
+	float norme = 0;
+	if (diff_met == diffus_methode_t::MonteCarlo) {
+		size_t i = std::clamp<int>( floorf((ang_incid/M_PI + 0.5f) * tables_n_incid), 0, tables_n_incid-1 );
+		repart_inv = &table_repart_inv[i * (tables_n_u+1)];
+		norme = table_norme[i];
+	}
 	
 	for (size_t k = 0; k < n_re_emit; k++) {
 
@@ -22,29 +107,39 @@ std::vector<Rayon> ObjetCourbe_Diffusant::re_emit (const Rayon& ray, std::shared
 				ang_refl = M_PI/2 * (1-2*rand01()); break;		// angles aléatoires équirépartis
 			case diffus_methode_t::Equirep:
 				ang_refl = M_PI/2 * (1-2*(k+1)/(float)(n_re_emit+1)); break;	// angles déterministes équirépartis
-			default:
-				throw std::runtime_error("TODO");
+			case diffus_methode_t::MonteCarlo: {
+				// θr tiré selon la BRDF, par interpolation de la fonction de répartition inverse
+				float x = rand01() * tables_n_u;
+				size_t m = std::min<size_t>(x, tables_n_u-1);
+				ang_refl = repart_inv[m] + (x - m) * (repart_inv[m+1] - repart_inv[m]);
+				break; }
 		}
 
 		Rayon ray_refl;
 		ray_refl.orig = intercept.p_incid;
-		ray_refl.dir_angle = intercept.ang_normale + ang_refl;
+		ray_refl.dir = intercept.normale.rotate(ang_refl);
 		
 		// pondération de l'intensité par la BRDF en fonction de l'angle incident et réfléchi
 		ray_refl.spectre = ray.spectre;
-		if (not BRDF_lambda) {
-			float ampl = albedo / n_re_emit * BRDF( intercept.ang_incid, ang_refl );
-			ray_refl.spectre.for_each([&] (float, pola_t, float& I) {
-				I *= ampl;
-			});
+		if (diff_met == diffus_methode_t::MonteCarlo) {
+			// densité de tirage ∝ BRDF : intensité identique pour tous les rayons ré-émis,
+			//  à la variation de la BRDF avec la couleur près (rapport à la BRDF moyenne)
+			ray_refl.spectre *= albedo / n_re_emit * norme;
+			if (BRDF_lambda) {
+				float f_moy = BRDF_moyenne(ang_incid, ang_refl);
+				ray_refl.spectre.for_each_cid([&] (color_id_t c, pola_t, float& I) {
+					I *= (f_moy > 0) ? tables_BRDF[c]( ang_incid, ang_refl ) / f_moy : 0;
+				});
+			}
+		} else if (not BRDF_lambda) {
+			float ampl = albedo / n_re_emit * tables_BRDF[0]( ang_incid, ang_refl );
+			ray_refl.spectre *= ampl;
 		} else {
-			ray_refl.spectre.for_each([&] (float lambda, pola_t, float& I) {
-				I *= albedo / n_re_emit * BRDF_lambda( intercept.ang_incid, ang_refl, lambda );
+			ray_refl.spectre.for_each_cid([&] (color_id_t c, pola_t, float& I) {
+				I *= albedo / n_re_emit * tables_BRDF[c]( ang_incid, ang_refl );
 			});
 		}
 		
-		rayons.push_back(std::move(ray_refl));
+		sortie.push_back(std::move(ray_refl));
 	}
-		
-	return rayons;
 }
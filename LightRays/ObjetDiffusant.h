@@ -6,6 +6,8 @@
 #define _LIGHTRAYS_DIFFUS_H_
 
 #include "ObjetsCourbes.h"
+#include <functional>
+#include <vector>
 
 class ObjetCourbe_Diffusant : virtual public ObjetCourbe {
 public:
@@ -14,7 +16,7 @@ public:
 	enum diffus_methode_t {
 		Equirep, // Équirépartition des rayons sur tous les angles i_r avec modulation d'amplitude par la BRDF
 		AleaUnif, // Émission aléatoire uniforme avec modulation d'amplitude par la BRDF
-		MonteCarlo, // Tirage de rayons d'intensité constante avec une distribution respectant la BRDF (Metropolis)
+		MonteCarlo, // Tirage de rayons d'intensité constante avec une distribution respectant la BRDF (tables de répartition inverse)
 	} diff_met;
 	// Bidirectional reflectance distribution function, possiblement dépendante de la couleur
 	std::function<float(float theta_i, float theta_r)> BRDF;                        // utilisée si `BRDF_lambda` nulle
@@ -25,7 +27,7 @@ public:
 	float n_re_emit_par_intens;
 	
 	static decltype(BRDF) BRDF_Lambert; // Diffusion lambertienne (isotrope <=> loi en cos(θ) <=> BRDF = 1)
-	static decltype(BRDF) BRDF_Oren_Nayar (float sigma); // Diffusion de Oren Nayar
+	static decltype(BRDF) BRDF_Oren_Nayar (float sigma); // Diffusion de Oren Nayar (surface rugueuse, `sigma` = écart-type des pentes des facettes, en radians)
 	
 	ObjetCourbe_Diffusant (decltype(BRDF) BRDF) : diff_met(AleaUnif), BRDF(BRDF), BRDF_lambda(nullptr), albedo(1), n_re_emit_par_intens(1) {}
 	ObjetCourbe_Diffusant& operator= (const ObjetCourbe_Diffusant&) = default;
@@ -33,7 +35,28 @@ public:
 	virtual ~ObjetCourbe_Diffusant () {};
 	
 	// Diffusion du rayon incident
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override final;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override final;
+	
+	// La BRDF n'est pas appelée pendant la propagation, mais tabulée (une table par couleur `lambda_color`
+	//  si `BRDF_lambda`) avec les tables de tirage de diffus_methode_t::MonteCarlo, au début de la propagation
+	//  suivant la configuration. À appeler après toute modification de `BRDF`, `BRDF_lambda` (sinon tables périmées)
+	void BRDF_modifiee () { tables_a_jour = false; }
+	virtual void pre_propagation () override;
+	
+private:
+	// BRDF(θi,θr) tabulée sur [-π/2,π/2]² (`tables_n_brdf`² points, interpolation bilinéaire) : une table
+	//  si `BRDF`, ou une table par couleur puis la table de la moyenne sur les couleurs si `BRDF_lambda`
+	static constexpr size_t tables_n_brdf = 129;
+	std::vector<table2d_t> tables_BRDF;
+	float BRDF_moyenne (float theta_i, float theta_r) const { return tables_BRDF.back()(theta_i, theta_r); }
+	// Pour chaque angle d'incidence θi (`tables_n_incid` intervalles sur [-π/2,π/2]), fonction de répartition
+	//  inverse de la distribution θr ∝ BRDF(θi,θr) (`tables_n_u`+1 points), et normalisation ∫BRDF(θi,θr)dθr / π.
+	//  Avec `BRDF_lambda`, la distribution tirée est celle de la BRDF moyenne sur les couleurs.
+	static constexpr size_t tables_n_incid = 128, tables_n_u = 256;
+	std::vector<float> table_repart_inv;
+	std::vector<float> table_norme;
+	bool tables_a_jour = false;
+	void construire_tables ();
 };
 
 class ObjetArc_Diffusant : virtual public ObjetCourbe_Diffusant, virtual public ObjetArc {
@@ -12,73 +12,133 @@ void ObjetComposite_LignesMilieu::re_positionne (point_t o) {
 	}
 }
 
+void ObjetComposite_LignesMilieu::dispersion_alea (bool alea) {
+	for (auto& obj : this->comp)
+		dynamic_cast<ObjetLigne_Milieux*>(&(*obj))->dispersion_alea = alea;
+}
+
 // Réflexion et réfraction sur un dioptre : lois de Snell-Descartes
 //  et coefficients de Fresnel. Voir lois.pdf pour plus de détails.
-// Deux cas : indice de réfraction indep. de λ (peu cher) et dépendant
-//  de λ (cher car séparation en N_COULEURS différentes)
+// Trois cas : indice de réfraction indep. de λ (peu cher), dépendant
+//  de λ (cher car séparation en N_COULEURS différentes), et dépendant
+//  de λ avec tirage d'une couleur par rayon réfracté (`dispersion_alea`)
 //
-std::vector<Rayon> ObjetCourbe_Milieux::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	intercept_courbe_t& intercept = *(intercept_courbe_t*)interception.get();
-	std::vector<Rayon> rays_emis;
+void ObjetCourbe_Milieux::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_courbe_t& intercept = interception.get<intercept_courbe_t>();
 	
 	Rayon ray_refl;
 	ray_refl.orig = intercept.p_incid;
-	ray_refl.dir_angle = intercept.ang_normale - intercept.ang_incid; // i_refl = i par rapport à la normale
+	float cosi = intercept.cos_incid(ray.dir);
+	ray_refl.dir = ray.dir + 2 * cosi * intercept.normale; // i_refl = i par rapport à la normale
 	ray_refl.spectre = ray.spectre;
 	
-	auto refracte = [&intercept,&rays_emis] (Rayon& ray_refl, float n_out, float n_in) {
+	auto refracte = [&ray,&intercept,cosi,&sortie] (Rayon& ray_refl, float n_out, float n_in) {
 		
 		float gamma = intercept.sens_reg ? n_out/n_in : n_in/n_out; // n1/n2
 		
-		float s = gamma * sinf(intercept.ang_incid);
+		float s = gamma * intercept.sin_incid(ray.dir);
 		
 		if (fabsf(s) <= 1) { // on a un rayon transmis (i <= i_critique)
 			
 			Rayon ray_trsm;
 			ray_trsm.orig = intercept.p_incid;
-			ray_trsm.dir_angle = (intercept.ang_normale + M_PI) + asinf(s);
 			
+			// t = γ.u + (γ.cos i - cos r).n, avec cos r = b
 			float b = sqrtf( 1 - s*s );
-			float cosi = cosf(intercept.ang_incid);
+			ray_trsm.dir = gamma * ray.dir + (gamma * cosi - b) * intercept.normale;
 			float a_TE = gamma * cosi, a_TM = cosi / gamma;
-			float r_coeff[2];
-			r_coeff [PolTE] = (a_TE - b) / (a_TE + b);
-			r_coeff [PolTM] = (a_TM - b) / (a_TM + b);
+			float r_TE = (a_TE - b) / (a_TE + b),
+			      r_TM = (a_TM - b) / (a_TM + b);
 			
-			Specte::for_each_manual([&] (uint8_t i, float lambda, pola_t pol) {
-				float R = r_coeff[pol] * r_coeff[pol];
-				ray_trsm.spectre.comps[i] = (1-R) * ray_refl.spectre.comps[i];
-				ray_refl.spectre.comps[i] =   R   * ray_refl.spectre.comps[i];
-			});
+			ray_trsm.spectre = ray_refl.spectre;
+			ray_trsm.spectre *= Specte::par_polarisation(1 - r_TE*r_TE, 1 - r_TM*r_TM);
+			ray_refl.spectre *= Specte::par_polarisation(r_TE*r_TE, r_TM*r_TM);
 			
-			rays_emis.push_back(ray_trsm);
+			sortie.push_back(ray_trsm);
 		}
 		// sinon, pas de rayon transmis (i > i_critique), et ray_refl est déjà prêt à être envoyé
 		
-		rays_emis.push_back(ray_refl);
+		sortie.push_back(ray_refl);
 	};
 	
 	// indice de réfraction fixe
 	if (not (bool)n_lambda) {
 		refracte (ray_refl, /*n_out*/1., /*n_in*/this->n_fixe);
 	}
+	// indice de réfraction dépendant de la longueur d'onde, une couleur tirée pour le rayon réfracté
+	//  -> le rayon réfléchi, de direction indépendante de λ, garde toutes les composantes (coefficients de Fresnel
+	//  de chaque couleur); le rayon réfracté est monochromatique, de couleur c tirée avec la probabilité
+	//  p_c = w_c/W (w_c intensité transmise dans la couleur c) et d'intensité W : estimateur sans biais,
+	//  exact si le rayon incident est déjà monochromatique (p_c = 1)
+	else if (dispersion_alea) {
+		float sini = intercept.sin_incid(ray.dir);
+		std::array<float,N_COULEURS> gamma, b {}, R_TE, R_TM;
+		for (color_id_t c = 0; c < N_COULEURS; c++) {
+			gamma[c] = intercept.sens_reg ? 1/n_couleurs[c] : n_couleurs[c];
+			float s = gamma[c] * sini;
+			if (fabsf(s) <= 1) {
+				b[c] = sqrtf( 1 - s*s );
+				float a_TE = gamma[c] * cosi, a_TM = cosi / gamma[c];
+				float r_TE = (a_TE - b[c]) / (a_TE + b[c]),
+				      r_TM = (a_TM - b[c]) / (a_TM + b[c]);
+				R_TE[c] = r_TE*r_TE;
+				R_TM[c] = r_TM*r_TM;
+			} else
+				R_TE[c] = R_TM[c] = 1; // réflexion totale
+		}
+		
+		Specte spectre_trsm = ray.spectre;
+		std::array<float,N_COULEURS> w {};
+		spectre_trsm.for_each_cid([&] (color_id_t c, pola_t pol, float& I) {
+			I *= 1 - (pol == PolTE ? R_TE[c] : R_TM[c]);
+			w[c] += I;
+		});
+		ray_refl.spectre.for_each_cid([&] (color_id_t c, pola_t pol, float& I) {
+			I *= (pol == PolTE ? R_TE[c] : R_TM[c]);
+		});
+		
+		float W = 0;
+		for (color_id_t c = 0; c < N_COULEURS; c++)
+			W += w[c];
+		if (W > 0) {
+			float u = W * rand01();
+			color_id_t c_tire = 0;
+			for (color_id_t c = 0; c < N_COULEURS; c++) {
+				if (w[c] > 0) {
+					c_tire = c;
+					if (u < w[c]) break;
+				}
+				u -= w[c];
+			}
+			Rayon ray_trsm;
+			ray_trsm.orig = intercept.p_incid;
+			ray_trsm.dir = gamma[c_tire] * ray.dir + (gamma[c_tire] * cosi - b[c_tire]) * intercept.normale;
+			ray_trsm.spectre = spectre_trsm;
+			ray_trsm.spectre *= Specte::monochromatique(W / w[c_tire], c_tire);
+			sortie.push_back(ray_trsm);
+		}
+		sortie.push_back(ray_refl);
+	}
 	// indice de réfraction dépendant de la longueur d'onde
 	//  -> séparation de toutes les composantes en rayons monochromatiques, car les directions sont différentes
 	else {
 		for (color_id_t i = 0; i < N_COULEURS; i++) {
 			Rayon ray_refl_mono = ray_refl;
-			ray_refl_mono.spectre.for_each_cid([&] (color_id_t cid, pola_t pol, float& I) {
-				if (cid != i)
-					I = 0;
-			});
-			float n_in = n_lambda(lambda_color[i]); // variable
-			refracte (ray_refl_mono, /*n_out*/1., n_in);
+			ray_refl_mono.spectre *= Specte::monochromatique(1, i);
+			refracte (ray_refl_mono, /*n_out*/1., /*n_in*/n_couleurs[i]);
 		}
 	}
-	
-	return rays_emis;
 }
 
+void ObjetCourbe_Milieux::pre_propagation () {
+	if ((bool)n_lambda) {
+		for (color_id_t i = 0; i < N_COULEURS; i++)
+			n_couleurs[i] = n_lambda(lambda_color[i]);
+	}
+}
+
+#ifndef NOSFML
+
 #include "sfml_c01.hpp"
 
 void ObjetLigne_Milieux::dessiner (sf::RenderWindow& window, bool emphasize) const {
@@ -92,3 +152,5 @@ void ObjetLigne_Milieux::dessiner (sf::RenderWindow& window, bool emphasize) con
 	rect_milieu.setFillColor(sf::Color(255,255,255,20));
 	window.draw(rect_milieu);
 }
+
+#endif
@@ -12,6 +12,10 @@
 #define _LIGHTRAYS_OBJET_MILIEU_H_
 
 #include "ObjetsCourbes.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
 
 //------------------------------------------------------------------------------
 // Dioptres de type courbe (1D) entre le vide et un milieu d'indice n, fixe
@@ -23,6 +27,10 @@ public:
 	
 	std::function<float(float)> n_lambda; // n(λ)    /!\ coûteux -> N_COULEURS rayons réfractés à lancer
 	float n_fixe; // n indépendant de λ, considéré si `indice_refr_lambda` est nul
+	// Si `n_lambda` : au lieu de séparer le rayon en N_COULEURS paires de rayons réfléchis/réfractés,
+	//  un seul rayon réfléchi (toutes couleurs) et un seul rayon réfracté, d'une couleur tirée au hasard
+	//  (probabilité proportionnelle à l'intensité transmise) : même espérance, bien moins de rayons
+	bool dispersion_alea = false;
 	
 	ObjetCourbe_Milieux (float incide_refr_fixe) : ObjetCourbe(), n_lambda(nullptr), n_fixe(incide_refr_fixe) {}
 	ObjetCourbe_Milieux (std::function<float(float)> indice_refr_lambda) : ObjetCourbe(), n_lambda(indice_refr_lambda) {}
@@ -32,7 +40,13 @@ public:
 	virtual ~ObjetCourbe_Milieux () {}
 	
 	// Ré-émission du rayons intercepté en un rayon réfléchi et un rayon réfracté
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override final;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override final;
+	
+	// Évaluation de `n_lambda` pour chaque couleur `lambda_color`, au début de chaque propagation
+	virtual void pre_propagation () override;
+	
+private:
+	std::array<float,N_COULEURS> n_couleurs;
 };
 
 //------------------------------------------------------------------------------
@@ -47,8 +61,10 @@ public:
 	
 	virtual ~ObjetLigne_Milieux () {}
 	
+#ifndef NOSFML
 	// Dessin (intérieur coloré)
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const override;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -87,6 +103,8 @@ public:
 	
 	// simple translation : positionnement du premier point de la chaine en `o`
 	void re_positionne (point_t o);
+	// ObjetCourbe_Milieux::dispersion_alea de toutes les lignes
+	void dispersion_alea (bool alea);
 };
 
 #endif
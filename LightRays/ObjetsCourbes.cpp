@@ -9,24 +9,24 @@
 // Relai de ObjetCourbe::essai_intercept_courbe
 //
 Objet::intercept_t ObjetCourbe::essai_intercept (const Rayon& ray) const {
-	auto intercept = this->essai_intercept_courbe(ray);
-	if (intercept.has_value()) {
-		float dist2 = (ray.orig - (*intercept)->p_incid).norm2();
+	intercept_courbe_struct_t intercept = this->essai_intercept_courbe(ray);
+	if (intercept) {
+		float t = intercept.get<intercept_courbe_t>().t;
 		// on introduit une distance minimale qu'un rayon peut parcourit avant d'être intercepté
 		// par une courbe pour éviter qu'un objet ré-intercepte immédiatement le rayon qu'il vient
 		// d'émettre, ce qui arriverait souvent en simple précision
-		if (dist2 < INTERCEPTION_DIST_MINIMALE*INTERCEPTION_DIST_MINIMALE)
-			return { .dist2 = Inf, .intercept_struct = nullptr };
+		if (t < INTERCEPTION_DIST_MINIMALE)
+			return { .t = Inf, .intercept_struct = nullptr };
 		else
-			return { .dist2 = dist2,
-					 .intercept_struct = std::static_pointer_cast<void>(*intercept) };
+			return { .t = t,
+					 .intercept_struct = intercept };
 	} else
-		return { .dist2 = Inf, .intercept_struct = nullptr };
+		return { .t = Inf, .intercept_struct = nullptr };
 }
 
-std::optional<point_t> ObjetCourbe::point_interception (std::shared_ptr<void> intercept_struct) const {
+std::optional<point_t> ObjetCourbe::point_interception (const intercept_struct_t& intercept_struct) const {
 	if (intercept_struct) {
-		return ((intercept_courbe_t*)intercept_struct.get())->p_incid;
+		return intercept_struct.get<intercept_courbe_t>().p_incid;
 	} else
 		return std::nullopt;
 }
@@ -44,10 +44,8 @@ vec_t ObjetLigne::vecteur_u_perp () const {
 
 // Routine d'intersection segment avec demi-droite
 //
-std::optional<ObjetLigne::intersection_segdd_t> ObjetLigne::intersection_segment_demidroite (point_t a, point_t b, point_t dd_orig, float angle) {
+std::optional<ObjetLigne::intersection_segdd_t> ObjetLigne::intersection_segment_demidroite (point_t a, point_t b, point_t dd_orig, vec_t u_dd) {
 	// cas particulier d'alignement non pris en compte
-	vec_t u_dd = { .x = cosf(angle),
-	               .y = sinf(angle) };
 	vec_t v_seg = a - b;
 	float s, t;
 	mat22_sol(v_seg.x, -u_dd.x,
@@ -62,30 +60,72 @@ std::optional<ObjetLigne::intersection_segdd_t> ObjetLigne::intersection_segment
 
 // Test d'interception du rayon sur la ligne.
 //
-std::optional<std::shared_ptr<ObjetCourbe::intercept_courbe_t>> ObjetLigne::essai_intercept_courbe (const Rayon& ray) const {
+ObjetCourbe::intercept_courbe_struct_t ObjetLigne::essai_intercept_courbe (const Rayon& ray) const {
 	// `intersection_segment_demidroite` n'est pas directement intégrée ici car elle sert ailleurs
-	auto isect = ObjetLigne::intersection_segment_demidroite(a, b, ray.orig, ray.dir_angle);
-	if (not isect.has_value())
-		return std::nullopt;
-	std::shared_ptr<intercept_ligne_t> intercept = std::make_shared<intercept_ligne_t>();
+	auto isect = ObjetLigne::intersection_segment_demidroite(a, b, ray.orig, ray.dir);
+	intercept_courbe_struct_t intercept;
+	if (isect.has_value())
+		intercept.creer(this->intercept_depuis_isect(ray, *isect));
+	return intercept;
+}
+
+ObjetLigne::intercept_ligne_t ObjetLigne::intercept_depuis_isect (const Rayon& ray, const intersection_segdd_t& isect) const {
+	intercept_ligne_t intercept;
 	// point d'incidence
-	intercept->p_incid = ray.orig + isect->t_dd * isect->u_dd;
-	intercept->s_incid = isect->s_seg;
-	// angle d'incidence
-	float seg_angle = atan2f(isect->v_seg.y, isect->v_seg.x);  // pourrait être calculé une bonne fois pour toutes
-	float alpha = angle_mod2pi_11(ray.dir_angle);
-	float i = alpha - (seg_angle - M_PI/2);
-	if (fabsf(angle_mod2pi_11(i)) < M_PI/2) {
-		intercept->ang_normale = seg_angle + M_PI/2;
-		intercept->ang_incid = i;
-		intercept->sens_reg = true;
+	intercept.p_incid = ray.orig + isect.t_dd * isect.u_dd;
+	intercept.t = isect.t_dd;
+	intercept.s_incid = isect.s_seg;
+	// normale du côté d'où vient le rayon
+	vec_t n = isect.v_seg.rotate_p90();  // pourrait être calculé une bonne fois pour toutes
+	n /= !n;
+	if ((isect.u_dd | n) < 0) {
+		intercept.normale = n;
+		intercept.sens_reg = true;
 	} else {
-		intercept->ang_incid = i - M_PI;
-		if (intercept->ang_incid < -M_PI/2) intercept->ang_incid += 2*M_PI;
-		intercept->ang_normale = seg_angle - M_PI/2;
-		intercept->sens_reg = false;
+		intercept.normale = -n;
+		intercept.sens_reg = false;
 	}
-	return std::shared_ptr<intercept_courbe_t>(intercept);
+	return intercept;
+}
+
+// Test d'interception d'un lot de rayons sur la ligne : même calcul que `intersection_segment_demidroite`,
+//  sur les tableaux du lot, sans allocation (boucle vectorisable)
+//
+void ObjetLigne::essai_intercept_lot (const LotRayons& lot, const std::vector<uint32_t>& i_rayons, uint32_t i_objet, intercept_lot_t& res) const {
+	vec_t v_seg = a - b;
+	const float* __restrict ox = lot.orig_x.data();
+	const float* __restrict oy = lot.orig_y.data();
+	const float* __restrict ux = lot.u_x.data();
+	const float* __restrict uy = lot.u_y.data();
+	float* __restrict t_min = res.t.data();
+	size_t n = i_rayons.size();
+	for (size_t j = 0; j < n; j++) {
+		uint32_t k = i_rayons[j];
+		float e = ox[k] - b.x, f = oy[k] - b.y;
+		float det = ux[k] * v_seg.y - v_seg.x * uy[k];
+		float s = (ux[k] * f - e * uy[k]) / det;
+		float t = (v_seg.x * f - e * v_seg.y) / det;
+		bool intercepte = (0 <= s and s <= 1)
+		                  and t >= INTERCEPTION_DIST_MINIMALE
+		                  and t < t_min[k];
+		if (intercepte) {
+			t_min[k] = t;
+			res.i_objet[k] = i_objet;
+			res.intercept_struct[k] = nullptr;
+			res.params[k] = { s, t };
+		}
+	}
+}
+
+ObjetCourbe::intercept_courbe_struct_t ObjetLigne::intercept_lot_courbe (const Rayon& ray, params_lot_t params) const {
+	intersection_segdd_t isect = {
+		.v_seg = a - b,
+		.u_dd = ray.dir,
+		.s_seg = params[0], .t_dd = params[1]
+	};
+	intercept_courbe_struct_t intercept;
+	intercept.creer(this->intercept_depuis_isect(ray, isect));
+	return intercept;
 }
 
 ///------------------------ ObjetArc ------------------------///
@@ -120,46 +160,90 @@ std::pair<point_t,point_t> ObjetArc::objet_extremit () const {
 	         c + R * u_b };
 }
 
-// Routine d'interception du rayon sur l'arc de cercle.
+// Intersection de la demi-droite avec l'arc de cercle.
 //
-std::optional<std::shared_ptr<ObjetArc::intercept_courbe_t>> ObjetArc::essai_intercept_courbe (const Rayon& ray) const {
-	/// intersection arc de cercle / demi-droite
-	// (notations de `lois.pdf`)
-	vec_t oc = c - ray.orig;
-	float b = !oc / R;  // d/R
-	float base_ang = atan2f(oc.y, oc.x);
-	// angles relatifs à l'axe OC
-	float alpha = angle_mod2pi_11( ray.dir_angle - base_ang );
-	angle_interv_t thetaAB = ang + -base_ang;
-	// intersection avec le cecle si en dessous de l'angle critique
-	float y = b * sinf(alpha);
-	if ((b > 1.00001 and fabsf(alpha) >= M_PI/2) or fabsf(y) > 1)
-		return std::nullopt;
-	// angles repérant les points d'intersection avec le cercle
-	float arcsiny = asinf(y);
-	float theta1 = alpha - arcsiny + M_PI,
-	      theta2 = alpha + arcsiny;
+bool ObjetArc::intersection_arc_demidroite (point_t o, vec_t u, float& t, bool& sortant) const {
+	/// intersection cercle / demi-droite : |o + t.u - c|² = R²
+	vec_t oc = c - o;
+	float proj = oc | u;                // abscisse de la projection de c sur la droite
+	float oc2 = oc.norm2();
+	float h2 = R*R - (oc2 - proj*proj); // demi-corde au carré
+	if (h2 < 0)
+		return false;
+	float h = sqrtf(h2);
+	// origine à l'extérieur du cercle (à la tolérance près)
+	bool ext = oc2 > R*R * 1.00001f*1.00001f;
+	if (ext and proj <= 0)
+		return false;
 	/// si on est bien sur notre arc de cercle
-	std::shared_ptr<intercept_arc_t> intercept = std::make_shared<intercept_arc_t>();
-	// θ1 n'est accessible que si la rayon vient de l'extérieur
-	if ( b > 1.00001 and thetaAB.inclus(theta1) ) {
-		intercept->sens_reg = !inv_int; // ext vers int du cerlce
-		intercept->theta_incid = intercept->ang_normale = theta1 + base_ang;
-		intercept->ang_incid = M_PI - theta1 + alpha; // c'est un angle relatif, pas besoin de base_ang
+	// t1 n'est accessible que si la rayon vient de l'extérieur
+	float t1 = proj - h,
+	      t2 = proj + h;
+	if ( ext and ang.inclus((o + t1 * u) - c) ) {
+		t = t1;
+		sortant = false;
+		return true;
 	}
-	// test de θ1 pour b<1 ou si θ1 a échoué pour b>1
-	else if ( thetaAB.inclus(theta2) ) {
-		intercept->sens_reg = inv_int; // int vers ext du cercle
-		intercept->theta_incid = theta2 + base_ang;
-		intercept->ang_normale = intercept->theta_incid + M_PI; // normale vers l'intérieur du cercle
-		intercept->ang_incid = alpha - theta2;
+	// test de t2 si intérieur ou si t1 a échoué pour extérieur
+	if ( t2 >= 0 and ang.inclus((o + t2 * u) - c) ) {
+		t = t2;
+		sortant = true;
+		return true;
 	}
-	else
-		return std::nullopt;
-	// calcul du point d'incidence
-	intercept->p_incid = c + R * vec_t{ .x = cosf(intercept->theta_incid),
-	                                    .y = sinf(intercept->theta_incid) };
-	return std::shared_ptr<intercept_courbe_t>(intercept);
+	return false;
+}
+
+ObjetCourbe::intercept_courbe_t ObjetArc::intercept_depuis_racine (const Rayon& ray, float t, bool sortant) const {
+	intercept_courbe_t intercept;
+	vec_t cp = (ray.orig + t * ray.dir) - c;
+	intercept.t = t;
+	intercept.p_incid = c + cp;
+	if (not sortant) {
+		intercept.sens_reg = !inv_int; // ext vers int du cerlce
+		intercept.normale = cp / R;  // normale vers l'extérieur du cercle
+	} else {
+		intercept.sens_reg = inv_int; // int vers ext du cercle
+		intercept.normale = cp / (-R); // normale vers l'intérieur du cercle
+	}
+	return intercept;
+}
+
+// Routine d'interception du rayon sur l'arc de cercle.
+//
+ObjetCourbe::intercept_courbe_struct_t ObjetArc::essai_intercept_courbe (const Rayon& ray) const {
+	float t; bool sortant;
+	intercept_courbe_struct_t intercept_struct;
+	if (this->intersection_arc_demidroite(ray.orig, ray.dir, t, sortant))
+		intercept_struct.creer(this->intercept_depuis_racine(ray, t, sortant));
+	return intercept_struct;
+}
+
+// Test d'interception d'un lot de rayons sur l'arc : pas de construction de `Rayon` ni d'appel virtuel par rayon
+//
+void ObjetArc::essai_intercept_lot (const LotRayons& lot, const std::vector<uint32_t>& i_rayons, uint32_t i_objet, intercept_lot_t& res) const {
+	const float* __restrict ox = lot.orig_x.data();
+	const float* __restrict oy = lot.orig_y.data();
+	const float* __restrict ux = lot.u_x.data();
+	const float* __restrict uy = lot.u_y.data();
+	float* __restrict t_min = res.t.data();
+	for (uint32_t k : i_rayons) {
+		float t; bool sortant;
+		bool intercepte = this->intersection_arc_demidroite(point_t{ ox[k], oy[k] }, vec_t{ ux[k], uy[k] }, t, sortant)
+		                  and t >= INTERCEPTION_DIST_MINIMALE
+		                  and t < t_min[k];
+		if (intercepte) {
+			t_min[k] = t;
+			res.i_objet[k] = i_objet;
+			res.intercept_struct[k] = nullptr;
+			res.params[k] = { t, (float)sortant };
+		}
+	}
+}
+
+ObjetCourbe::intercept_courbe_struct_t ObjetArc::intercept_lot_courbe (const Rayon& ray, params_lot_t params) const {
+	intercept_courbe_struct_t intercept;
+	intercept.creer(this->intercept_depuis_racine(ray, params[0], params[1] != 0));
+	return intercept;
 }
 
 ///------------------------ ObjetComposite ------------------------///
@@ -171,7 +255,8 @@ std::optional<std::shared_ptr<ObjetArc::intercept_courbe_t>> ObjetArc::essai_int
 //  (non-optimal, mais se comporte bien dans la plupart des cas)
 //
 Objet::extension_t ObjetComposite::objet_extension () const {
-	std::vector<vec_t> pos (comp.size());
+	std::vector<vec_t> pos;
+	pos.reserve(comp.size());
 	vec_t bary = {0,0};
 	float rayon_max = 0;
 	for (const auto& obj : comp) {
@@ -191,46 +276,87 @@ Objet::extension_t ObjetComposite::objet_extension () const {
 //  par l'objet le plus proche sur le chemin du rayon.
 //
 Objet::intercept_t ObjetComposite::essai_intercept (const Rayon& ray) const {
-	intercept_composite_t interception { .courbe_intercept = comp.end() };
-	float dist2_min = Inf;
+	intercept_composite_t interception;
+	float t_min = Inf;
 	// Test d'interception du rayon contre toutes les courbes composantes;
 	//  la première interception en terme de distance entre l'origine du rayon
 	//  et le point d'incidence est choisie (recherche de minimum)
-	for (auto it = comp.begin(); it != comp.end(); it++) {
-		std::optional<std::shared_ptr<ObjetCourbe::intercept_courbe_t>> intercept
-		= (*it)->essai_intercept_courbe(ray);
-		if (intercept.has_value()) {
-			float dist2 = (ray.orig - (*intercept)->p_incid).norm2();
-			if (dist2 < INTERCEPTION_DIST_MINIMALE*INTERCEPTION_DIST_MINIMALE)
+	for (uint32_t i = 0; i < comp.size(); i++) {
+		ObjetCourbe::intercept_courbe_struct_t intercept = comp[i]->essai_intercept_courbe(ray);
+		if (intercept) {
+			float t = intercept.get<ObjetCourbe::intercept_courbe_t>().t;
+			if (t < INTERCEPTION_DIST_MINIMALE)
 				continue;
-			if (dist2 < dist2_min) {
-				interception.courbe_intercept = it;
-				interception.intercept_struct = *intercept;
-				dist2_min = dist2;
+			if (t < t_min) {
+				interception.i_courbe = i;
+				interception.intercept_struct = intercept;
+				t_min = t;
 			}
 		}
 	}
-	return { .dist2 = dist2_min,
-	         .intercept_struct = (interception.courbe_intercept == comp.end()) ?
-	                             nullptr :
-	                             std::make_shared<intercept_composite_t>(interception)
-	};
+	intercept_t res = { .t = t_min, .intercept_struct = nullptr };
+	if (t_min != Inf)
+		res.intercept_struct.creer(interception);
+	return res;
 }
 
-std::optional<point_t> ObjetComposite::point_interception (std::shared_ptr<void> interception) const {
+// Relai du test par lots : chaque courbe teste le lot dans `res_comp`, initialisé aux distances
+//  courantes, de sorte qu'à la fin n'y subsistent que les interceptions plus proches par la
+//  courbe la plus proche (les courbes étant testées dans l'ordre, comme dans `essai_intercept`)
+//
+void ObjetComposite::essai_intercept_lot (const LotRayons& lot, const std::vector<uint32_t>& i_rayons, uint32_t i_objet, intercept_lot_t& res) const {
+	thread_local intercept_lot_t res_comp; // mémoire réutilisée d'un appel à l'autre
+	if (res_comp.t.size() < lot.taille())
+		res_comp.initialiser(lot.taille());
+	for (uint32_t k : i_rayons) {
+		res_comp.t[k] = res.t[k];
+		res_comp.i_objet[k] = UINT32_MAX;
+	}
+	for (uint32_t i = 0; i < comp.size(); i++)
+		comp[i]->essai_intercept_lot(lot, i_rayons, i, res_comp);
+	for (uint32_t k : i_rayons) {
+		uint32_t i = res_comp.i_objet[k];
+		if (i == UINT32_MAX)
+			continue;
+		res.t[k] = res_comp.t[k];
+		res.i_objet[k] = i_objet;
+		if (res_comp.intercept_struct[k]) {
+			// courbe sans test par lots : structure reconstruite à partir du rayon
+			intercept_composite_t interception = { i, comp[i]->essai_intercept_courbe(lot.rayon(k)) };
+			res.intercept_struct[k].creer(interception);
+		} else {
+			res.intercept_struct[k] = nullptr;
+			res.params[k] = { res_comp.params[k][0], res_comp.params[k][1], (float)i };
+		}
+	}
+}
+
+Objet::intercept_struct_t ObjetComposite::intercept_lot_struct (const Rayon& ray, params_lot_t params) const {
+	uint32_t i = (uint32_t)params[2];
+	intercept_composite_t interception = { i, comp[i]->intercept_lot_courbe(ray, params) };
+	intercept_struct_t intercept;
+	intercept.creer(interception);
+	return intercept;
+}
+
+std::optional<point_t> ObjetComposite::point_interception (const intercept_struct_t& interception) const {
 	if (interception) {
-		const intercept_composite_t& intercept = *(intercept_composite_t*)interception.get();
-		if (intercept.courbe_intercept != comp.end())
-			return intercept.intercept_struct->p_incid;
+		const intercept_composite_t& intercept = interception.get<intercept_composite_t>();
+		return intercept.intercept_struct.get<ObjetCourbe::intercept_courbe_t>().p_incid;
 	}
 	return std::nullopt;
 }
 
+void ObjetComposite::pre_propagation () {
+	for (const auto& obj : comp)
+		obj->pre_propagation();
+}
+
 // Simple ré-émission par la courbe qui a intercepté le rayon
 //
-std::vector<Rayon> ObjetComposite::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	const intercept_composite_t& intercept = *(intercept_composite_t*)interception.get();
-	return (*intercept.courbe_intercept)->re_emit(ray, intercept.intercept_struct);
+void ObjetComposite::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_composite_t& intercept = interception.get<intercept_composite_t>();
+	comp[intercept.i_courbe]->re_emit(ray, intercept.intercept_struct, sortie);
 }
 
 // Test de fermeture
@@ -255,6 +381,8 @@ void ObjetComposite::test_fermeture () const {
 
 ///------------------------ Affichages ------------------------///
 
+#ifndef NOSFML
+
 #include "sfml_c01.hpp"
 
 void ObjetLigne::dessiner (sf::RenderWindow& window, bool emphasize) const {
@@ -262,8 +390,8 @@ void ObjetLigne::dessiner (sf::RenderWindow& window, bool emphasize) const {
 	window.draw(line);
 }
 
-void ObjetCourbe::dessiner_interception (sf::RenderWindow& window, const Rayon& ray, std::shared_ptr<void> interception) const {
-	const intercept_courbe_t& intercept = *(intercept_courbe_t*)interception.get();
+void ObjetCourbe::dessiner_interception (sf::RenderWindow& window, const Rayon& ray, const intercept_struct_t& interception) const {
+	const intercept_courbe_t& intercept = interception.get<intercept_courbe_t>();
 	// dessin du rayon source -> objet
 	auto c = ray.spectre.rgb256_noir_intensite(false, std::nullopt);
 	auto line = sf::c01::buildLine(ray.orig,
@@ -271,7 +399,7 @@ void ObjetCourbe::dessiner_interception (sf::RenderWindow& window, const Rayon&
 	                               sf::Color(std::get<0>(c), std::get<1>(c), std::get<2>(c), 255));
 	window.draw(line);
 	// dessin de la normale au point d'interception
-	vec_t v = 0.03 * vec_t{ .x = cosf(intercept.ang_normale), .y = sinf(intercept.ang_normale) };
+	vec_t v = 0.03 * intercept.normale;
 	line = sf::c01::buildLine(intercept.p_incid+(-0.2)*v,
 	                          intercept.p_incid+(+0.8)*v,
 	                          intercept.sens_reg ? sf::Color(255,200,200) : sf::Color(200,200,255));
@@ -296,7 +424,9 @@ void ObjetComposite::dessiner (sf::RenderWindow& window, bool emphasize) const {
 		p->dessiner(window, emphasize);
 }
 
-void ObjetComposite::dessiner_interception (sf::RenderWindow& window, const Rayon& ray, std::shared_ptr<void> interception) const {
-	const intercept_composite_t& intercept = *(intercept_composite_t*)interception.get();
-	(*intercept.courbe_intercept)->dessiner_interception(window, ray, intercept.intercept_struct);
+void ObjetComposite::dessiner_interception (sf::RenderWindow& window, const Rayon& ray, const intercept_struct_t& interception) const {
+	const intercept_composite_t& intercept = interception.get<intercept_composite_t>();
+	comp[intercept.i_courbe]->dessiner_interception(window, ray, intercept.intercept_struct);
 }
+
+#endif
@@ -8,36 +8,56 @@
 #define _LIGHTRAYS_OBJETS_COURBES_H_
 
 #include "Objet.h"
+#include <cmath>
+#include <memory>
+#include <array>
+#include <vector>
+#include <utility>
+#include <cstdint>
 
 //------------------------------------------------------------------------------
 // Objet optique courbe. Déclare la structure d'interception commune donnant
-//  le point d'intersection, l'angle d'incidence (angle du rayon à la normale),
-//  l'angle absolu `ang_normale` du vecteur normal à la courbe (par rapport à
-//  l'horizontale), et le sens d'incidence du rayon `sens_reg` (l'objet étant
+//  le point d'intersection, la distance paramétrique `t` le long du rayon,
+//  le vecteur unitaire `normale` à la courbe (orienté du côté d'où vient le
+//  rayon), et le sens d'incidence du rayon `sens_reg` (l'objet étant
 //  orienté; `true` si même sens que sur les figures du document).
+// Les cosinus et sinus de l'angle d'incidence (angle du rayon à la normale)
+//  s'obtiennent par produits scalaire et vectoriel, sans trigonométrie.
 
 class ObjetCourbe : virtual public Objet {
 public:
 	struct intercept_courbe_t {
 		point_t p_incid;
-		float ang_incid;
-		float ang_normale;
+		vec_t normale;
+		float t;
 		bool sens_reg;
+		// cosinus, sinus et angle d'incidence du rayon de direction `u`
+		float cos_incid (vec_t u) const { return -(u | normale); }
+		float sin_incid (vec_t u) const { return normale.y * u.x - normale.x * u.y; }
+		float ang_incid (vec_t u) const { return atan2f(sin_incid(u), cos_incid(u)); }
 	};
 	
 	// Pour faciliter l'utilisation des `ObjetCourbe`, la méthode `essai_intercept_courbe` revoie
-	// directement un pointeur de `intercept_courbe_t`, au lieu de la structure opaque renvoyée par `essai_intercept`.
-	virtual std::optional<std::shared_ptr<intercept_courbe_t>> essai_intercept_courbe (const Rayon& ray) const = 0;
+	// directement une structure contenant un `intercept_courbe_t` (ou une classe dérivée), vide si pas
+	// d'interception, plus petite que la structure opaque renvoyée par `essai_intercept`.
+	using intercept_courbe_struct_t = InterceptStruct<32>;
+	virtual intercept_courbe_struct_t essai_intercept_courbe (const Rayon& ray) const = 0;
 	// `essai_intercept` est alors une simple redirection vers `essai_intercept_courbe` et calcul de distance
 	virtual Objet::intercept_t essai_intercept (const Rayon& ray) const override final;
+	// Test par lots (voir Objet::essai_intercept_lot) : de même, la structure d'interception d'une courbe
+	//  est construite par `intercept_lot_courbe`, et `intercept_lot_struct` n'en est que la redirection
+	virtual intercept_courbe_struct_t intercept_lot_courbe (const Rayon& ray, params_lot_t params) const { return {}; }
+	virtual intercept_struct_t intercept_lot_struct (const Rayon& ray, params_lot_t params) const override final { return this->intercept_lot_courbe(ray, params); }
 	// Le point d'interception est toujours défini pour les `ObjetCourbe`
-	virtual std::optional<point_t> point_interception (std::shared_ptr<void> intercept_struct) const override;
+	virtual std::optional<point_t> point_interception (const intercept_struct_t& intercept_struct) const override;
 	
 	// Extrémités de la courbe. Utilisé pour vérifier qu'un `ObjetComposite` est fermé.
 	virtual std::pair<point_t,point_t> objet_extremit () const = 0;
 	
+#ifndef NOSFML
 	// Dessin de l'interception : affiche le rayon et la normale
-	virtual void dessiner_interception (sf::RenderWindow& window, const Rayon& ray, std::shared_ptr<void> intercept) const override;
+	virtual void dessiner_interception (sf::RenderWindow& window, const Rayon& ray, const intercept_struct_t& intercept) const override;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -57,33 +77,43 @@ public:
 	ObjetLigne (const ObjetLigne&) = default;
 	virtual ~ObjetLigne () {}
 	
-	// Routine d'intersection segment [seg_a,seg_b] avec demi-droite définie par son origine `o_droite` et un angle `ang_droite`.
+	// Routine d'intersection segment [seg_a,seg_b] avec demi-droite définie par son origine `o_droite` et son vecteur unitaire `u_droite`.
 	// Retrourne (si intersection) le vecteur segment et le vecteur unitaire rayon (pour opti) et l'abscisse `s_seg` sur le segment et `t_dd` de la demi-droite du point d'intersection
 	struct intersection_segdd_t { vec_t v_seg; vec_t u_dd; float s_seg; float t_dd; };
-	static std::optional<intersection_segdd_t> intersection_segment_demidroite (point_t seg_a, point_t seg_b, point_t o_droite, float ang_droite);
+	static std::optional<intersection_segdd_t> intersection_segment_demidroite (point_t seg_a, point_t seg_b, point_t o_droite, vec_t u_droite);
 	// Test d'interception du rayon sur la ligne.
-	// Si interception, renvoie un pointeur de intercept_ligne_t
+	// Si interception, renvoie une structure contenant un intercept_ligne_t
 	struct intercept_ligne_t : public ObjetCourbe::intercept_courbe_t {
 		float s_incid;
 	};
-	std::optional<std::shared_ptr<intercept_courbe_t>> essai_intercept_courbe (const Rayon& ray) const override final;
+	intercept_courbe_struct_t essai_intercept_courbe (const Rayon& ray) const override final;
+	
+	// Test d'interception vectorisé d'un lot de rayons; la structure d'interception est construite
+	//  après coup pour le seul segment retenu, à partir de `params` = { s_seg, t_dd }
+	virtual void essai_intercept_lot (const LotRayons& lot, const std::vector<uint32_t>& i_rayons, uint32_t i_objet, intercept_lot_t& res) const override;
+	virtual intercept_courbe_struct_t intercept_lot_courbe (const Rayon& ray, params_lot_t params) const override;
 	
 	// Extension et extrémités du segment
 	virtual extension_t objet_extension () const override { return { .pos = a + (b-a)/2, .rayon = !(b-a) }; }
 	virtual std::pair<point_t,point_t> objet_extremit () const override { return {a, b}; }
 
+#ifndef NOSFML
 	// Dessin
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const override;
+#endif
 	vec_t vecteur_u_perp () const; // vecteur unitaire perpendiculaire au segment
+	
+private:
+	// Construction de la structure d'interception à partir de l'intersection segment/demi-droite
+	intercept_ligne_t intercept_depuis_isect (const Rayon& ray, const intersection_segdd_t& isect) const;
 };
 
 //------------------------------------------------------------------------------
 // Objet optique en forme d'arc de cercle, de centre `c`, de rayon `R`, entre les
 //  deux angles par rapport à l'horizontale définis par l'intervalle angulaire
 //  `ang` dans le sens trigonométrique. Routine d'intersection rayon-arc de cercle
-//  implémentée ici `courbe_intercept` renvoie une stucture `intercept_arc_t`
-//  donnant, en plus de `intercept_curve_t`, l'angle absolu (par rapport à
-//  l'horizontale) `theta_incid` du point d'incidence (dans l'intervalle `ang`).
+//  implémentée ici (forme vectorielle : équation du second degré en `t`, puis
+//  appartenance du point à l'arc par produits vectoriels).
 // Si `inv_int`=true, l'intérieur du cercle est marqué comme étant le milieu extérieur.
 
 class ObjetArc : virtual public ObjetCourbe {
@@ -103,18 +133,29 @@ public:
 	virtual ~ObjetArc () {}
 	
 	// Routine d'interception du rayon sur l'arc de cercle.
-	// Si interception, renvoie un pointeur de intercept_courbe_t
-	struct intercept_arc_t : public ObjetCourbe::intercept_courbe_t {
-		float theta_incid;
-	};
-	std::optional<std::shared_ptr<intercept_courbe_t>> essai_intercept_courbe (const Rayon& ray) const override final;
+	// Si interception, renvoie une structure contenant un intercept_courbe_t
+	intercept_courbe_struct_t essai_intercept_courbe (const Rayon& ray) const override final;
+	
+	// Test d'interception d'un lot de rayons (même équation, sur les tableaux du lot); la structure
+	//  d'interception est construite après coup pour le seul arc retenu, à partir de `params` = { t, racine }
+	//  (racine 0 : entrée dans le cercle, 1 : sortie)
+	virtual void essai_intercept_lot (const LotRayons& lot, const std::vector<uint32_t>& i_rayons, uint32_t i_objet, intercept_lot_t& res) const override;
+	virtual intercept_courbe_struct_t intercept_lot_courbe (const Rayon& ray, params_lot_t params) const override;
 	
 	// Extension et extrémités de l'arc
 	virtual extension_t objet_extension () const override { return { .pos = c, .rayon = R }; }
 	virtual std::pair<point_t,point_t> objet_extremit () const override;
 	
+#ifndef NOSFML
 	// Dessin
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const override;
+#endif
+	
+private:
+	// Intersection de la demi-droite (o,u) avec l'arc : distance `t` et racine (`sortant` : sortie du cercle)
+	bool intersection_arc_demidroite (point_t o, vec_t u, float& t, bool& sortant) const;
+	// Construction de la structure d'interception à partir de la racine trouvée
+	intercept_courbe_t intercept_depuis_racine (const Rayon& ray, float t, bool sortant) const;
 };
 
 //------------------------------------------------------------------------------
@@ -142,20 +183,26 @@ public:
 	
 	// Interception : si il y a, le rayon est simplement intercepté par l'objet le plus proche sur son chemin
 	struct intercept_composite_t {
-		decltype(comp)::const_iterator courbe_intercept; // itérateur de la courbe interceptée; `comp.end()` si pas d'interception
-		std::shared_ptr<ObjetCourbe::intercept_courbe_t> intercept_struct; // structure d'interception de cette courbe
+		uint32_t i_courbe; // indice de la courbe interceptée dans `comp`
+		ObjetCourbe::intercept_courbe_struct_t intercept_struct; // structure d'interception de cette courbe
 	};
 	virtual Objet::intercept_t essai_intercept (const Rayon& ray) const override;
-	virtual std::optional<point_t> point_interception (std::shared_ptr<void> intercept_struct) const override;
+	virtual std::optional<point_t> point_interception (const intercept_struct_t& intercept_struct) const override;
+	// Test par lots relayé aux sous-courbes; `params` = { paramètres de la courbe, indice de la courbe }
+	virtual void essai_intercept_lot (const LotRayons& lot, const std::vector<uint32_t>& i_rayons, uint32_t i_objet, intercept_lot_t& res) const override;
+	virtual intercept_struct_t intercept_lot_struct (const Rayon& ray, params_lot_t params) const override;
 	
 	virtual extension_t objet_extension () const override;
+	virtual void pre_propagation () override;
 	
 	// Simple ré-émission par le sous-objet qui a intercepté
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override;
 	
+#ifndef NOSFML
 	// Dessin
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const override;
-	virtual void dessiner_interception (sf::RenderWindow& window, const Rayon& ray, std::shared_ptr<void> intercept) const override;
+	virtual void dessiner_interception (sf::RenderWindow& window, const Rayon& ray, const intercept_struct_t& intercept) const override;
+#endif
 };
 
 #endif
@@ -1,5 +1,8 @@
 #include "ObjetsOptiques.h"
+#include "PoolThreads.h"
+#ifndef NOSFML
 #include "sfml_c01.hpp"
+#endif
 #include <cmath>
 
 Objet_MatriceTrsfUnidir::Objet_MatriceTrsfUnidir (point_t centre, float diam, float angv, mat_trsf_t m) : ObjetLigne({0,0}, {0,0}), mat_trsf(m) {
@@ -8,6 +11,7 @@ Objet_MatriceTrsfUnidir::Objet_MatriceTrsfUnidir (point_t centre, float diam, fl
 	b = centre + -v;
 }
 
+#ifndef NOSFML
 // Dessin d'un Objet_MatriceTrsfUnidir : on rajoute une ligne qui marque le côté sortant
 //
 void Objet_MatriceTrsfUnidir::dessiner (sf::RenderWindow& window, bool emphasize) const {
@@ -15,63 +19,86 @@ void Objet_MatriceTrsfUnidir::dessiner (sf::RenderWindow& window, bool emphasize
 	point_t o = milieu_2points(a,b);
 	window.draw(sf::c01::buildLine(o, o + 0.05 * vecteur_u_perp(), sf::Color(100,100,100)));
 }
+#endif
 
 // Objet_MatriceTrsfUnidir : Application de la matrice ABCD sur le rayon intercepté, dans le sens direct uniquement
 //
-std::vector<Rayon> Objet_MatriceTrsfUnidir::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	intercept_ligne_t& intercept = *(intercept_ligne_t*)interception.get();
-	std::vector<Rayon> rays;
+void Objet_MatriceTrsfUnidir::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_ligne_t& intercept = interception.get<intercept_ligne_t>();
 	if (intercept.sens_reg) {
 		float diam = !(a-b);
 		float y = (1 - 2 * intercept.s_incid) * diam/2;	// élévation incidente
-		float yp = tanf(intercept.ang_incid);			// pente incidente
+		float yp = intercept.sin_incid(ray.dir) / intercept.cos_incid(ray.dir);	// pente incidente
 		float y2 =  mat_trsf.A * y + mat_trsf.B * yp;	// élévation en sortie
 		float y2p = mat_trsf.C * y + mat_trsf.D * yp;	// pente en sortie
 		Rayon raytrsf = ray;
 		raytrsf.orig = milieu_2points(a,b) + y2 * (b-a)/diam;
-		raytrsf.dir_angle = atanf(y2p);
-		rays.push_back(std::move(raytrsf));
+		vec_t e_x = -intercept.normale;					// axe optique, dans le sens de propagation
+		raytrsf.dir = e_x + y2p * e_x.rotate_p90();
+		raytrsf.dir /= !raytrsf.dir;
+		sortie.push_back(std::move(raytrsf));
 	}
-	return rays;
 }
 
 // Objet_Filtre : filtrage du rayon incident : simple multiplication composante par composante du spectre par le spectre de transmission
 //
-std::vector<Rayon> Objet_Filtre::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	intercept_courbe_t& intercept = *(intercept_courbe_t*)interception.get();
+void Objet_Filtre::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_courbe_t& intercept = interception.get<intercept_courbe_t>();
 	Rayon ray_filtre = ray;
 	ray_filtre.orig = intercept.p_incid;
-	Specte::for_each_manual([&] (size_t i, float lambda, pola_t pol) -> void {
-		ray_filtre.spectre.comps[i] *= transm.comps[i];
-	});
-	return { std::move(ray_filtre) };
+	ray_filtre.spectre *= transm;
+	sortie.push_back(std::move(ray_filtre));
 }
 
 // Miroir : simple réflexion par rapport à la normale au point incident
 //
-std::vector<Rayon> ObjetCourbe_Miroir::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	intercept_courbe_t& intercept = *(intercept_courbe_t*)interception.get();
-	std::vector<Rayon> ray_emis;
+void ObjetCourbe_Miroir::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_courbe_t& intercept = interception.get<intercept_courbe_t>();
 	Rayon ray_refl;
 	ray_refl.orig = intercept.p_incid;
-	ray_refl.dir_angle = intercept.ang_normale - intercept.ang_incid; // i_refl = i par rapport à la normale
+	ray_refl.dir = ray.dir - 2 * (ray.dir | intercept.normale) * intercept.normale; // i_refl = i par rapport à la normale
 	ray_refl.spectre = ray.spectre;
-	ray_emis.push_back(std::move(ray_refl));
-	return ray_emis;
+	sortie.push_back(std::move(ray_refl));
 }
 
-// Bilan d'énergie : accumulation des flux entrants et sortants
+// Bilan d'énergie : accumulation des flux entrants et sortants (dans l'accumulateur du thread courant)
 //
-std::vector<Rayon> Objet_BilanEnergie::re_emit (const Rayon& ray, std::shared_ptr<void> interception) {
-	intercept_courbe_t& intercept = *(intercept_courbe_t*)interception.get();
+void Objet_BilanEnergie::re_emit (const Rayon& ray, const intercept_struct_t& interception, std::vector<Rayon>& sortie) {
+	const intercept_courbe_t& intercept = interception.get<intercept_courbe_t>();
+	size_t i_thread = PoolThreads::i_thread();
+	flux_t& f = (i_thread == 0) ? flux : flux_threads[i_thread-1];
 	Rayon rayon = ray;
 	rayon.orig = intercept.p_incid;
 	if (intercept.sens_reg) {
-		n_ray_in += 1;
-		flux_in += rayon.spectre.intensite_tot();
+		f.n_ray_in += 1;
+		f.flux_in += rayon.spectre.intensite_tot();
 	} else {
-		n_ray_out += 1;
-		flux_out += rayon.spectre.intensite_tot();
+		f.n_ray_out += 1;
+		f.flux_out += rayon.spectre.intensite_tot();
+	}
+	sortie.push_back(std::move(rayon));
+}
+
+void Objet_BilanEnergie::reset () {
+	n_acc = 0;
+	flux = {0, 0, 0, 0};
+	std::fill(flux_threads.begin(), flux_threads.end(), flux_t{0, 0, 0, 0});
+	this->publier_instantane();
+}
+
+void Objet_BilanEnergie::preparer_threads (size_t n_threads) {
+	flux_threads.resize(std::max<size_t>(1, n_threads) - 1, flux_t{0, 0, 0, 0});
+}
+
+void Objet_BilanEnergie::publier_instantane () {
+	instantane.ecriture() = { flux.flux_in/n_acc, flux.flux_out/n_acc, flux.n_ray_in/(float)n_acc, flux.n_ray_out/(float)n_acc };
+	instantane.publier();
+}
+
+void Objet_BilanEnergie::fusion_threads () {
+	for (flux_t& f : flux_threads) {
+		flux.flux_in += f.flux_in;   flux.flux_out += f.flux_out;
+		flux.n_ray_in += f.n_ray_in; flux.n_ray_out += f.n_ray_out;
+		f = {0, 0, 0, 0};
 	}
-	return { std::move(rayon) };
 }
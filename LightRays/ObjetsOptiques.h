@@ -7,6 +7,8 @@
 #define _LIGHTRAYS_OPTIQUES_H_
 
 #include "ObjetsCourbes.h"
+#include "Ecran.h"
+#include <vector>
 
 //------------------------------------------------------------------------------
 // Objet "matrice ABCD" unidirectionnel : objet linéaire transmettant les rayons
@@ -33,9 +35,11 @@ public:
 	Objet_MatriceTrsfUnidir (const Objet_MatriceTrsfUnidir&) = default;
 	virtual ~Objet_MatriceTrsfUnidir () {}
 	
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override;
 	
+#ifndef NOSFML
 	virtual void dessiner (sf::RenderWindow& window, bool emphasize) const override final;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -46,8 +50,8 @@ public:
 	Objet_Bloqueur (point_t pos_a, point_t pos_b) : ObjetLigne(pos_a,pos_b) {}
 	virtual ~Objet_Bloqueur () {}
 	
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override final {
-		return {}; // oublie simplement le rayon
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override final {
+		// oublie simplement le rayon
 	}
 };
 
@@ -73,7 +77,7 @@ public:
 	virtual ~Objet_Filtre () {}
 	
 	// Transmission du rayon filtré
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override;
 };
 
 //------------------------------------------------------------------------------
@@ -86,7 +90,7 @@ public:
 	virtual ~ObjetCourbe_Miroir () {}
 	
 	// Réflexion parfaite du rayon
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override final;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override final;
 };
 
 //------------------------------------------------------------------------------
@@ -115,32 +119,42 @@ public:
 // Objet "bilan d'énergie" : intercepte les rayons sur un cercle et somme les
 // flux entrants et sortants. Utile pour vérifier la conservation de l'intensité
 // par un objet. Les rayons interceptés sont ré-émis à l'identique.
+// Accumule comme un écran (commit, reset et accumulateurs par thread).
 
-class Objet_BilanEnergie : virtual public ObjetArc {
+class Objet_BilanEnergie : virtual public Ecran_Base, virtual public ObjetArc {
 private:
-	float flux_in, flux_out;
-	size_t n_ray_in, n_ray_out;
-	size_t n_acc;
+	struct flux_t {
+		float flux_in, flux_out;
+		size_t n_ray_in, n_ray_out;
+	};
+	flux_t flux;
+	std::vector<flux_t> flux_threads; // accumulateurs privés des threads 1 à n-1
+protected:
+	virtual void fusion_threads () override;
+	virtual void publier_instantane () override;
 public:
 	Objet_BilanEnergie (point_t centre, float radius) :
-		ObjetArc(centre, radius, angle_interv_t::cercle_entier, false),
-		flux_in(0), flux_out(0), n_ray_in(0), n_ray_out(0), n_acc(0) {}
+		Ecran_Base(), ObjetArc(centre, radius, angle_interv_t::cercle_entier, false),
+		flux({0, 0, 0, 0}) { this->publier_instantane(); }
 	
 	Objet_BilanEnergie& operator= (const Objet_MatriceTrsfUnidir&) = delete;
 	Objet_BilanEnergie (const Objet_MatriceTrsfUnidir&) = delete;
 	virtual ~Objet_BilanEnergie () {}
 	
 	// intercepte les rayons et accumule les flux entrants et sortants
-	virtual std::vector<Rayon> re_emit (const Rayon& ray, std::shared_ptr<void> intercept) override final;
+	virtual void re_emit (const Rayon& ray, const intercept_struct_t& intercept, std::vector<Rayon>& sortie) override final;
 	
-	// typiquement appelé à chaque frame, pour moyenner les valeurs sur plusieurs frames
-	void commit () { n_acc++; }
-	void reset () { flux_in = flux_out = 0; n_ray_in = n_ray_out = n_acc = 0; }
-	// statistiques de flux : intensité entrante, intensité sortante, nombre de rayons entrants et sortants
+	// `commit` typiquement appelé à chaque frame, pour moyenner les valeurs sur plusieurs frames
+	virtual void reset () override;
+	virtual void preparer_threads (size_t n_threads) override;
+	// statistiques de flux : intensité entrante, intensité sortante, nombre de rayons entrants et sortants,
+	//  au dernier `commit` (lisibles sans verrou comme EcranLigne_Multi::matrice_pixels)
 	struct stats_par_frame_t {
 		float flux_in, flux_out, n_ray_in, n_ray_out;
 	};
-	stats_par_frame_t bilan () { return { flux_in/n_acc, flux_out/n_acc, n_ray_in/(float)n_acc, n_ray_out/(float)n_acc }; }
+	stats_par_frame_t bilan () { instantane.actualiser(); return instantane.lu(); }
+private:
+	TamponTriple<stats_par_frame_t> instantane;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "PoolThreads.h"
+
+static thread_local size_t pool_i_thread = 0;
+
+size_t PoolThreads::i_thread () {
+	return pool_i_thread;
+}
+
+PoolThreads::PoolThreads (size_t n_threads) : generation(0), n_en_cours(0), arret(false), exception(nullptr) {
+	for (size_t i = 1; i < n_threads; i++)
+		threads.emplace_back(&PoolThreads::boucle_thread, this, i);
+}
+
+PoolThreads::~PoolThreads () {
+	{
+		std::lock_guard<std::mutex> lock (mtx);
+		arret = true;
+	}
+	cv_travail.notify_all();
+	for (std::thread& t : threads)
+		t.join();
+}
+
+// Boucle des threads auxiliaires : attente d'un nouveau travail, exécution, signalement de la fin
+//
+void PoolThreads::boucle_thread (size_t i_thread) {
+	pool_i_thread = i_thread;
+	uint64_t generation_faite = 0;
+	while (true) {
+		std::function<void(size_t)> f;
+		{
+			std::unique_lock<std::mutex> lock (mtx);
+			cv_travail.wait(lock, [&] { return arret or generation != generation_faite; });
+			if (arret)
+				return;
+			generation_faite = generation;
+			f = travail;
+		}
+		try {
+			f(i_thread);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock (mtx);
+			if (not exception)
+				exception = std::current_exception();
+		}
+		{
+			std::lock_guard<std::mutex> lock (mtx);
+			n_en_cours--;
+		}
+		cv_fini.notify_one();
+	}
+}
+
+void PoolThreads::executer (std::function<void(size_t i_thread)> f) {
+	{
+		std::lock_guard<std::mutex> lock (mtx);
+		travail = f;
+		exception = nullptr;
+		n_en_cours = threads.size();
+		generation++;
+	}
+	cv_travail.notify_all();
+	std::exception_ptr exception_principal = nullptr;
+	try {
+		f(0);
+	} catch (...) {
+		exception_principal = std::current_exception();
+	}
+	std::unique_lock<std::mutex> lock (mtx);
+	cv_fini.wait(lock, [&] { return n_en_cours == 0; });
+	travail = nullptr;
+	if (exception_principal)
+		std::rethrow_exception(exception_principal);
+	if (exception)
+		std::rethrow_exception(exception);
+}
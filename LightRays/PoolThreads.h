@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Pool de threads persistants, pour la propagation multi-thread des rayons.
+ *******************************************************************************/
+
+#ifndef _LIGHTRAYS_POOL_THREADS_H_
+#define _LIGHTRAYS_POOL_THREADS_H_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+//------------------------------------------------------------------------------
+// Pool de `n_threads` threads : le thread appelant (indice 0) et `n_threads-1`
+//  threads auxiliaires, créés une fois pour toutes et endormis entre deux
+//  appels à `executer`. La répartition du travail entre threads est laissée
+//  à l'appelant (typiquement, un compteur atomique de tâches).
+
+class PoolThreads {
+private:
+	std::vector<std::thread> threads;
+	std::mutex mtx;
+	std::condition_variable cv_travail, cv_fini;
+	std::function<void(size_t)> travail; // travail en cours, appelé avec l'indice du thread
+	uint64_t generation; // incrémenté à chaque appel de `executer`
+	size_t n_en_cours; // nombre de threads auxiliaires n'ayant pas fini le travail en cours
+	bool arret;
+	std::exception_ptr exception; // première exception levée par un thread auxiliaire
+
+	void boucle_thread (size_t i_thread);
+
+public:
+	PoolThreads (size_t n_threads);
+	PoolThreads (const PoolThreads&) = delete;
+	PoolThreads& operator= (const PoolThreads&) = delete;
+	~PoolThreads ();
+
+	size_t n_threads () const { return threads.size() + 1; }
+
+	// Exécute `f(i_thread)` sur chacun des threads, y compris le thread appelant (d'indice 0),
+	//  et attend que tous aient terminé. Une exception levée par un des threads est relancée ici.
+	void executer (std::function<void(size_t i_thread)> f);
+
+	// Indice du thread courant dans le pool qui l'exécute (0 pour le thread principal)
+	static size_t i_thread ();
+};
+
+//------------------------------------------------------------------------------
+// Tampon triple sans verrou entre un écrivain et un lecteur (threads différents) :
+//  l'écrivain remplit `ecriture()` puis le publie avec `publier()`, sans jamais
+//  attendre; le lecteur récupère la dernière valeur publiée avec `actualiser()`,
+//  et la lit avec `lu()`, inchangée jusqu'à son prochain `actualiser()`.
+// Typiquement : instantané d'un écran écrit par la propagation, lu par l'affichage.
+
+template <typename T>
+class TamponTriple {
+private:
+	std::array<T,3> tampons;
+	static constexpr uint8_t bit_nouveau = 4; // dans `milieu` : valeur publiée pas encore récupérée
+	uint8_t i_ecriture = 0, i_lecture = 1;
+	std::atomic<uint8_t> milieu { 2 };
+	
+public:
+	TamponTriple () = default;
+	TamponTriple (const TamponTriple& o) : tampons(o.tampons), i_ecriture(o.i_ecriture), i_lecture(o.i_lecture), milieu(o.milieu.load()) {}
+	TamponTriple& operator= (const TamponTriple& o) {
+		tampons = o.tampons; i_ecriture = o.i_ecriture; i_lecture = o.i_lecture; milieu = o.milieu.load();
+		return *this;
+	}
+	
+	// Écrivain
+	T& ecriture () { return tampons[i_ecriture]; }
+	void publier () {
+		i_ecriture = milieu.exchange(i_ecriture | bit_nouveau, std::memory_order_acq_rel) & 3;
+	}
+	// Lecteur : vrai si une nouvelle valeur a été publiée depuis le dernier appel
+	bool actualiser () {
+		if (not (milieu.load(std::memory_order_relaxed) & bit_nouveau))
+			return false;
+		i_lecture = milieu.exchange(i_lecture, std::memory_order_acq_rel) & 3;
+		return true;
+	}
+	const T& lu () const { return tampons[i_lecture]; }
+};
+
+#endif
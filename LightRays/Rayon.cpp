@@ -1,5 +1,6 @@
 #include "Rayon.h"
 #include "cmath"
+#include <stdexcept>
 
 // Spectre dont les composantes sont ajustées pour avoir à peu près du blanc en affichage RBG
 const Specte spectre_blanc = Specte::polychromatique({{0.8,0.8,1.7,2.2}});
@@ -21,13 +22,30 @@ Specte Specte::monochromatique (float A, color_id_t color_id, std::optional<pola
 	return specte;
 }
 
-Specte Specte::polychromatique (std::array<float,N_COULEURS> I, std::optional<pola_t> pola_sel) {
+Specte Specte::par_polarisation (float I_TE, float I_TM) {
+	Specte specte;
+	for (uint8_t i = 0; i < 2*N_COULEURS; i += 2) {
+		specte.comps[i+PolTE] = I_TE;
+		specte.comps[i+PolTM] = I_TM;
+	}
+	return specte;
+}
+
+Specte Specte::polychromatique (const std::vector<float>& I, std::optional<pola_t> pola_sel) {
+	if (I.empty())
+		throw std::invalid_argument("spectre vide");
 	Specte specte;
 	Specte::for_each_manual([&] (size_t i, float lambda, pola_t pol) {
 		if (pola_sel.has_value() and *pola_sel != pol) {
 			specte.comps[i] = 0;
-		} else {
+		} else if (I.size() == N_COULEURS) {
 			specte.comps[i] = I[i/2];
+		} else if (I.size() == 1) {
+			specte.comps[i] = I[0];
+		} else {
+			float x = (LAMBDA_MAX - lambda) / (LAMBDA_MAX - LAMBDA_MIN) * (I.size() - 1);
+			size_t k = std::min<size_t>(floorf(std::max(0.f, x)), I.size() - 2);
+			specte.comps[i] = I[k] + (x - k) * (I[k+1] - I[k]);
 		}
 	});
 	return specte;
@@ -62,25 +80,27 @@ std::tuple<float,float,float> wavelenght_to_rgb (float lamda, float gamma) {
 	return { R, G, B };
 }
 
+// Poids RGB de chaque composante, pour la projection du spectre en couleur RGB
 struct rgb_cache_t {
-	std::array< std::tuple<float,float,float>, 2*N_COULEURS> comp_couleurs_rgb;
+	alignas(32) std::array<float,2*N_COULEURS> r, g, b;
 	rgb_cache_t () {
 		Specte::for_each_manual([&] (uint8_t i_comp_array, float lambda, pola_t pol) {
-			comp_couleurs_rgb[i_comp_array] = wavelenght_to_rgb( lambda );
+			std::tie(r[i_comp_array], g[i_comp_array], b[i_comp_array]) = wavelenght_to_rgb( lambda );
 		});
 	}
 } rgb_cache;
 
 std::tuple<uint8_t,uint8_t,uint8_t,bool> Specte::rgb256_noir_intensite (bool chroma_only, std::optional<pola_t> pola_sel) const {
+	// composantes sélectionnées
+	Specte sp = *this;
+	if (pola_sel.has_value())
+		sp *= Specte::par_polarisation(*pola_sel == PolTE, *pola_sel == PolTM);
 	float I_r = 0, I_g = 0, I_b = 0;
-	Specte::for_each_manual([&] (uint8_t i_comp_array, float lambda, pola_t pol) {
-		if (pola_sel.has_value() and *pola_sel != pol)
-			return;
-		float rc, gc, bc; std::tie(rc,gc,bc) = /* wavelenght_to_rgb(lambda) */ rgb_cache.comp_couleurs_rgb[i_comp_array];
-		I_r += rc * comps[i_comp_array];
-		I_g += gc * comps[i_comp_array];
-		I_b += bc * comps[i_comp_array];
-	});
+	for (uint8_t i = 0; i < 2*N_COULEURS; i++) {
+		I_r += rgb_cache.r[i] * sp.comps[i];
+		I_g += rgb_cache.g[i] * sp.comps[i];
+		I_b += rgb_cache.b[i] * sp.comps[i];
+	}
 	I_r /= 2*N_COULEURS;
 	I_g /= 2*N_COULEURS;
 	I_b /= 2*N_COULEURS;
@@ -94,20 +114,45 @@ std::tuple<uint8_t,uint8_t,uint8_t,bool> Specte::rgb256_noir_intensite (bool chr
 
 float Specte::intensite_tot (pola_t pola_sel) const {
 	float I_tot = 0;
-	Specte::for_each_manual([&] (uint8_t i_comp_array, float, pola_t pol) {
-		if (pola_sel != pol)
-			return;
-		I_tot += comps[i_comp_array];
-	});
+	for (uint8_t i = pola_sel; i < 2*N_COULEURS; i += 2)
+		I_tot += comps[i];
 	I_tot /= 2*N_COULEURS;
 	return I_tot;
 }
 
-float Specte::intensite_tot () const {
-	float I_tot = 0;
-	Specte::for_each_manual([&] (uint8_t i_comp_array, float, pola_t) {
-		I_tot += comps[i_comp_array];
-	});
-	I_tot /= 2*N_COULEURS;
-	return I_tot;
+///------------------------ LotRayons ------------------------///
+
+void LotRayons::vider () {
+	orig_x.clear(); orig_y.clear(); u_x.clear(); u_y.clear();
+	for (auto& c : comps)
+		c.clear();
+	profondeur.clear();
+}
+
+void LotRayons::ajouter (const Rayon& ray, uint16_t prof) {
+	orig_x.push_back(ray.orig.x);
+	orig_y.push_back(ray.orig.y);
+	u_x.push_back(ray.dir.x);
+	u_y.push_back(ray.dir.y);
+	for (uint8_t i = 0; i < 2*N_COULEURS; i++)
+		comps[i].push_back(ray.spectre.comps[i]);
+	profondeur.push_back(prof);
+}
+
+Rayon LotRayons::rayon (size_t k) const {
+	Rayon ray;
+	ray.orig = { orig_x[k], orig_y[k] };
+	ray.dir = { u_x[k], u_y[k] };
+	for (uint8_t i = 0; i < 2*N_COULEURS; i++)
+		ray.spectre.comps[i] = comps[i][k];
+	return ray;
+}
+
+void LotRayons::calculer_directions () {
+	size_t n = taille();
+	inv_u_x.resize(n); inv_u_y.resize(n);
+	for (size_t k = 0; k < n; k++) {
+		inv_u_x[k] = 1.f / u_x[k];
+		inv_u_y[k] = 1.f / u_y[k];
+	}
 }
\ No newline at end of file
@@ -8,16 +8,42 @@
 #include <array>
 #include <functional>
 #include <tuple>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
 #include "Util.h"
 
+// Nombre de composantes spectrales des rayons, fixé à la compilation (`-DN_COULEURS=...`, voir Makefile) :
+//  2 pour un aperçu rapide, 4 par défaut, 16 ou 32 pour une dispersion plus précise.
+//  Toutes les unités de compilation doivent être compilées avec la même valeur.
+#ifndef N_COULEURS
 #define N_COULEURS 4
+#endif
+static_assert(N_COULEURS >= 1 and N_COULEURS <= 64, "N_COULEURS invalide");
 
-// Longueurs d'ondes des `N_COULEURS` composantes des rayons
-constexpr float lambda_color [N_COULEURS] = {
-	7e-4, 6e-4, 5e-4, 4e-4
-};
+// Longueurs d'ondes des `N_COULEURS` composantes des rayons, équiréparties
+//  de `LAMBDA_MAX` à `LAMBDA_MIN` (en mm; 700, 600, 500, 400nm pour N_COULEURS = 4)
+#define LAMBDA_MAX 7e-4
+#define LAMBDA_MIN 4e-4
+constexpr std::array<float,N_COULEURS> lambda_color_generer () {
+	std::array<float,N_COULEURS> lambdas {};
+	for (size_t i = 0; i < N_COULEURS; i++)
+		lambdas[i] = (N_COULEURS == 1) ? (LAMBDA_MAX + LAMBDA_MIN) / 2
+		                               : LAMBDA_MAX - (LAMBDA_MAX - LAMBDA_MIN) * i / (N_COULEURS - 1);
+	return lambdas;
+}
+constexpr std::array<float,N_COULEURS> lambda_color = lambda_color_generer();
 // La position dans ce tableau définit un `color_id_t`
 typedef uint8_t color_id_t;
+// Couleur dont la longueur d'onde est la plus proche de `lambda` (en mm), valide quel que soit N_COULEURS
+inline color_id_t couleur_proche (float lambda) {
+	color_id_t c_proche = 0;
+	for (color_id_t c = 1; c < N_COULEURS; c++)
+		if (fabsf(lambda_color[c] - lambda) < fabsf(lambda_color[c_proche] - lambda))
+			c_proche = c;
+	return c_proche;
+}
 
 // Conversion longueur d'onde -> RGB pour affichage
 std::tuple<float,float,float> wavelenght_to_rgb (float lamda_mm, float gamma = 0.8);
@@ -30,32 +56,66 @@ enum pola_t { PolTE = 0, PolTM = 1 };
 
 // Spectre en intensité/puissance (suivant le contexte) d'un rayonnement, discrétisé en `N_COULEURS`
 //  (×2 pour la polarisation TE/TM) composantes de longueur d'onde définies `lambda_color`.
-// La manipulation de `AmplComp::comps` doit se faire systématiquement avec for_each ou for_each_manual { ampl[i_comp_array] }.
+// La manipulation de `AmplComp::comps` doit se faire systématiquement avec for_each ou for_each_manual { ampl[i_comp_array] },
+//  ou, de préférence, avec les opérations arithmétiques ci-dessous, qui sont de simples boucles de taille fixe
+//  sur un tableau aligné, vectorisées par le compilateur (2×4 composantes = un registre AVX).
 //
-struct Specte {
+struct alignas(2*N_COULEURS*sizeof(float) >= 32 ? 32 : 2*N_COULEURS*sizeof(float)) Specte {
 	std::array<float,2*N_COULEURS> comps;
 	
-	inline static void for_each_manual (std::function<void(uint8_t i_comp_array, float lambda, pola_t pol)> f) {
+	template <typename F> // f(uint8_t i_comp_array, float lambda, pola_t pol)
+	inline static void for_each_manual (F&& f) {
 		for (uint8_t i = 0; i < 2*N_COULEURS; i++)
 			f(i, lambda_color[i/2], i%2==0 ? pola_t::PolTE : pola_t::PolTM);
 	}
-	inline void for_each (std::function<void(float lambda, pola_t pol, float& I)> f) {			// version mutable avec lambda
+	template <typename F> // f(float lambda, pola_t pol, float& I)
+	inline void for_each (F&& f) {			// version mutable avec lambda
 		for_each_manual([&] (uint8_t i, float lambda, pola_t pol) {  f(lambda, pol, this->comps[i]);  });
 	}
-	inline void for_each_cid (std::function<void(color_id_t cid, pola_t pol, float& I)> f) {	// version mutable avec id de couleur
+	template <typename F> // f(color_id_t cid, pola_t pol, float& I)
+	inline void for_each_cid (F&& f) {		// version mutable avec id de couleur
 		for_each_manual([&] (uint8_t i, float, pola_t pol) {  f(i/2, pol, this->comps[i]);  });
 	}
-	inline void for_each (std::function<void(float lambda, pola_t pol, float I)> f) const {		// version constante avec lambda
+	template <typename F> // f(float lambda, pola_t pol, float I)
+	inline void for_each (F&& f) const {	// version constante avec lambda
 		for_each_manual([&] (uint8_t i, float lambda, pola_t pol) {  f(lambda, pol, this->comps[i]);  });
 	}
 	
 	static Specte monochromatique (float I, color_id_t id, std::optional<pola_t> pol = std::nullopt);
-	static Specte polychromatique (std::array<float,N_COULEURS> I, std::optional<pola_t> pol = std::nullopt);
+	// Spectre donné par ses intensités `I` à K longueurs d'onde équiréparties de `LAMBDA_MAX` à `LAMBDA_MIN`,
+	//  interpolées linéairement sur les `lambda_color` (identique aux composantes si K = `N_COULEURS`)
+	static Specte polychromatique (const std::vector<float>& I, std::optional<pola_t> pol = std::nullopt);
+	// Spectre valant `I_TE` (resp. `I_TM`) sur toutes les composantes de polarisation TE (resp. TM)
+	static Specte par_polarisation (float I_TE, float I_TM);
+	
+	// Opérations composante par composante : mise à l'échelle, filtrage (multiplication par un
+	//  spectre de transmission), accumulation et accumulation pondérée (`*this += a * sp`)
+	Specte& operator*= (float a) {
+		for (uint8_t i = 0; i < 2*N_COULEURS; i++) comps[i] *= a;
+		return *this;
+	}
+	Specte& operator*= (const Specte& transm) {
+		for (uint8_t i = 0; i < 2*N_COULEURS; i++) comps[i] *= transm.comps[i];
+		return *this;
+	}
+	Specte& operator+= (const Specte& sp) {
+		for (uint8_t i = 0; i < 2*N_COULEURS; i++) comps[i] += sp.comps[i];
+		return *this;
+	}
+	void ajouter_pondere (float a, const Specte& sp) {
+		for (uint8_t i = 0; i < 2*N_COULEURS; i++) comps[i] += a * sp.comps[i];
+	}
+	// Somme des composantes
+	float somme () const {
+		float s = 0;
+		for (uint8_t i = 0; i < 2*N_COULEURS; i++) s += comps[i];
+		return s;
+	}
 	
 	// Sommation des intensités de chaque composante (intégration sur tout le spectre),
 	// et division par le nombre de composantes (2×`N_COULEURS`).
 	// Optionellement, sélectionne seulement les composantes d'une polarisation donnée.
-	float intensite_tot () const;
+	float intensite_tot () const { return somme() / (2*N_COULEURS); }
 	float intensite_tot (pola_t pola_sel) const;
 	
 	// Conversion du spectre en couleur RGB pour affichage sur fond noir, par rapport à une intensité
@@ -69,13 +129,33 @@ struct Specte {
 // Spectre tel que l'affichage RGB est à peu près blanc
 extern const Specte spectre_blanc;
 
-// Définition d'un rayon : son origine, son angle à l'horizontale
+// Définition d'un rayon : son origine, son vecteur directeur unitaire
 //  et son spectre en intensité associé.
+// La direction est un vecteur plutôt qu'un angle pour que les tests d'interception et les
+//  ré-émissions (réflexion, réfraction) se fassent sans fonctions trigonométriques.
 //
 struct Rayon {
 	point_t orig;
-	float dir_angle;
+	vec_t dir;
 	Specte spectre;
 };
 
+// Lot de rayons stocké en structure de tableaux (une composante par tableau), pour les
+//  traitements par lots (voir Scene::emission_propagation_lots et Objet::essai_intercept_lot).
+// Les inverses des composantes du vecteur directeur (tests de boîtes englobantes) sont calculés
+//  une fois pour tout le lot avec `calculer_directions`.
+//
+struct LotRayons {
+	std::vector<float> orig_x, orig_y;
+	std::array< std::vector<float>, 2*N_COULEURS > comps;
+	std::vector<uint16_t> profondeur;
+	std::vector<float> u_x, u_y, inv_u_x, inv_u_y;
+	
+	size_t taille () const { return orig_x.size(); }
+	void vider ();
+	void ajouter (const Rayon& ray, uint16_t prof);
+	Rayon rayon (size_t k) const;
+	void calculer_directions ();
+};
+
 #endif
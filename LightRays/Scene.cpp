@@ -1,87 +1,513 @@
 #include "Scene.h"
 #include <cmath>
+#include <atomic>
+#include <chrono>
+#ifdef LIGHTRAYS_PROFIL
+#include <algorithm>
+#include <iomanip>
+#include <typeinfo>
+#include <cxxabi.h>
+#endif
+#ifndef NOSFML
 #include "sfml_c01.hpp"
+#endif
+
+// Temps écoulé depuis `t`, en secondes, et `t` mis à l'instant présent
+//
+static double chrono_tour (std::chrono::steady_clock::time_point& t) {
+	auto t_prec = t;
+	t = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(t - t_prec).count();
+}
 
 // Test d'interception du rayon contre toutes les objets de la scène puis renvoi des
-//  rayons ré-émis; la première interception sur le trajet du rayon est choisie.
+//  rayons ré-émis dans `sortie`; la première interception sur le trajet du rayon est choisie.
 // Voir ObjetComposite::essai_intercept_composite pour un code similaire.
 //
-std::vector<Rayon> Scene::interception_re_emission (const Rayon& ray) {
+void Scene::interception_re_emission (const Rayon& ray, std::vector<Rayon>& sortie) {
 	
 	decltype(objets)::const_iterator objet_intercept = objets.end();
-	std::shared_ptr<void> intercept_struct;
-	float dist2_min = Inf;
+	Objet::intercept_struct_t intercept_struct;
+	float t_min = Inf;
+	
+#ifdef LIGHTRAYS_PROFIL
+	contexte_thread_t& ctx = contextes_threads[PoolThreads::i_thread()];
+	std::vector<profil_objet_t>& profil = ctx.profil;
+	bool chrono = (ctx.profil_compteur++ % profil_echantillonnage) == 0;
+	auto essai = [&] (size_t i) -> Objet::intercept_t {
+		if (not chrono) {
+			profil[i].n_essais++;
+			Objet::intercept_t intercept = objets[i]->essai_intercept(ray);
+			profil[i].n_interceptions += (intercept.t != Inf);
+			return intercept;
+		}
+		auto t = std::chrono::steady_clock::now();
+		Objet::intercept_t intercept = objets[i]->essai_intercept(ray);
+		profil[i].temps_essais += profil_echantillonnage * chrono_tour(t);
+		profil[i].n_essais++;
+		if (intercept.t != Inf)
+			profil[i].n_interceptions++;
+		return intercept;
+	};
+#else
+	auto essai = [&] (size_t i) -> Objet::intercept_t {
+		return objets[i]->essai_intercept(ray);
+	};
+#endif
 	
-	for (auto it = objets.begin(); it != objets.end(); it++) {
-		// Objet::extension_t ex = (*it)->objet_extension();
-		// Todo. Pour que ça puisse apporter quelque chose, il faut que ça soit calculé à l'avance et faire une grille et un test très rapide
-		#warning To do
-		Objet::intercept_t intercept = (*it)->essai_intercept(ray);
-		if (intercept.dist2 < dist2_min) {
-			dist2_min = intercept.dist2;
-			objet_intercept = it;
+	if (propag_bvh and bvh.taille() == objets.size()) {
+		// Parcours de la hiérarchie de volumes englobants : seuls les objets dont l'extension
+		//  est traversée par le rayon avant la plus proche interception trouvée sont testés
+		Objet::intercept_t intercept;
+		size_t i_min = bvh.parcours(ray, essai, intercept);
+		if (i_min != SIZE_MAX) {
+			objet_intercept = objets.begin() + i_min;
 			intercept_struct = intercept.intercept_struct;
 		}
+	} else {
+		for (size_t i = 0; i < objets.size(); i++) {
+			Objet::intercept_t intercept = essai(i);
+			if (intercept.t < t_min) {
+				t_min = intercept.t;
+				objet_intercept = objets.begin() + i;
+				intercept_struct = intercept.intercept_struct;
+			}
+		}
 	}
 	
-	if (objet_intercept == objets.end())
-		return {};
-	else {
-		if (propag_intercept_dessin_window != nullptr)
-			(*objet_intercept)->dessiner_interception(*propag_intercept_dessin_window, ray, intercept_struct);
-		if (propag_rayons_dessin_window != nullptr) {
-			auto p = (*objet_intercept)->point_interception(intercept_struct);
-			if (p.has_value()) {
-				float c = propag_rayons_dessin_gain * ray.spectre.intensite_tot();
-				auto line = sf::c01::buildLine(ray.orig, *p, sf::Color(255, 255, 255, (uint8_t)std::min(255.f,c)));
-				propag_rayons_dessin_window->draw(line);
+	if (objet_intercept != objets.end()) {
+#ifdef LIGHTRAYS_PROFIL
+		profil_objet_t& p = profil[objet_intercept - objets.begin()];
+		size_t n_sortie = sortie.size();
+		auto t = std::chrono::steady_clock::now();
+		this->re_emission(**objet_intercept, ray, intercept_struct, sortie);
+		if (chrono)
+			p.temps_re_emit += profil_echantillonnage * chrono_tour(t);
+		p.n_retenues++;
+		p.n_rayons_emis += sortie.size() - n_sortie;
+#else
+		this->re_emission(**objet_intercept, ray, intercept_struct, sortie);
+#endif
+	}
+}
+
+void Scene::re_emission (Objet& objet, const Rayon& ray, const Objet::intercept_struct_t& intercept_struct, std::vector<Rayon>& sortie) {
+	bool segment = (bool)fluence;
+#ifndef NOSFML
+	if (propag_intercept_dessin_window != nullptr)
+		objet.dessiner_interception(*propag_intercept_dessin_window, ray, intercept_struct);
+	segment = segment or propag_rayons_dessin_window != nullptr;
+#endif
+	// segment parcouru par le rayon, pour la carte de fluence et le dessin des rayons
+	if (segment) {
+		auto p = objet.point_interception(intercept_struct);
+		if (p.has_value()) {
+			float I = ray.spectre.intensite_tot();
+			if (fluence)
+				fluence->ajouter_segment(ray.orig, *p, I);
+#ifndef NOSFML
+			if (propag_rayons_dessin_window != nullptr) {
+				float c = propag_rayons_dessin_gain * I;
+				sf::c01::appendLine(propag_rayons_dessin_lignes[PoolThreads::i_thread()], ray.orig, *p, sf::Color(255, 255, 255, (uint8_t)std::min(255.f,c)));
 			}
+#endif
 		}
-		if (propag_intercept_cb)
-			propag_intercept_cb(**objet_intercept, ray, intercept_struct);
-		return (*objet_intercept)->re_emit(ray, intercept_struct);
 	}
+	if (propag_intercept_cb)
+		propag_intercept_cb(objet, ray, intercept_struct);
+	objet.re_emit(ray, intercept_struct, sortie);
+}
+
+Scene::stats_t& Scene::stats_t::operator+= (const stats_t& o) {
+	n_rayons += o.n_rayons;
+	n_rayons_profmax += o.n_rayons_profmax;
+	n_rayons_discarded += o.n_rayons_discarded;
+	sum_prof_recur += o.sum_prof_recur;
+	n_rayons_emis += o.n_rayons_emis;
+	intens_jetee += o.intens_jetee;
+	intens_roulette += o.intens_roulette;
+	return *this;
 }
 
-// Fonction récurrente : interception par les objets de la scène puis ré-émission
-//  avec la méthode `interception_re_emission`.
+// Coupure en intensité ou roulette russe
 //
-void Scene::propagation_recur (const Rayon& ray, uint16_t profondeur_recur) {
-	stats_sum_prof_recur += profondeur_recur;
-	if (profondeur_recur >= propag_profondeur_recur_max) {
-		stats_n_rayons_profmax++;
-		return;
+bool Scene::test_intensite (Rayon& ray, stats_t& stats) {
+	float I = ray.spectre.intensite_tot();
+	if (I >= intens_cutoff)
+		return true;
+	if (propag_roulette and rand01() * intens_cutoff < I) {
+		// survie avec la probabilité I/intens_cutoff, pondération par l'inverse
+		ray.spectre *= intens_cutoff / I;
+		stats.intens_roulette += intens_cutoff - I;
+		return true;
 	}
-	stats_n_rayons++;
-	std::vector<Rayon> rays = this->interception_re_emission(ray);
-	profondeur_recur++;
-	for (const Rayon& ray : rays) {
-		if (ray.spectre.intensite_tot() < intens_cutoff) {
-			stats_n_rayons_discarded++;
+	stats.n_rayons_discarded++;
+	stats.intens_jetee += I;
+	return false;
+}
+
+// Propagation d'un rayon primaire : interception par les objets de la scène puis ré-émission avec
+//  la méthode `interception_re_emission`, répétée sur les rayons ré-émis. Les rayons ré-émis sont
+//  empilés en ordre inverse pour être traités dans le même ordre que par une récursion, et le test
+//  d'intensité et `propag_emit_cb` sont faits au dépilement, juste avant leur propagation.
+//
+void Scene::propagation (const Rayon& ray_primaire, contexte_thread_t& ctx) {
+	std::vector<rayon_pile_t>& pile = ctx.pile;
+	pile.clear();
+	pile.push_back({ ray_primaire, 0 });
+	while (not pile.empty()) {
+		rayon_pile_t e = std::move(pile.back());
+		pile.pop_back();
+		if (e.profondeur != 0) { // rayon ré-émis
+			if (not this->test_intensite(e.ray, ctx.stats))
+				continue;
+			if (propag_emit_cb)
+				propag_emit_cb(e.ray, e.profondeur);
+		}
+		ctx.stats.sum_prof_recur += e.profondeur;
+		if (e.profondeur >= propag_profondeur_recur_max) {
+			ctx.stats.n_rayons_profmax++;
 			continue;
 		}
-		if (propag_emit_cb)
-			propag_emit_cb(ray, profondeur_recur);
-		this->propagation_recur(ray, profondeur_recur);
+		ctx.stats.n_rayons++;
+		ctx.emis.clear();
+		this->interception_re_emission(e.ray, ctx.emis);
+		for (auto it = ctx.emis.rbegin(); it != ctx.emis.rend(); it++)
+			pile.push_back({ std::move(*it), (uint16_t)(e.profondeur + 1) });
 	}
 }
 
-// Émet les rayons de toutes les sources de la scène et appelle `propagation_recur`.
+// Construit la hiérarchie de volumes englobants des objets (qui ont pu bouger depuis
+//  la dernière frame), émet les rayons de toutes les sources et appelle `propagation`.
+// En multi-thread, les rayons primaires de toutes les sources sont générés d'abord, puis
+//  propagés par paquets distribués dynamiquement entre les threads.
 //
 void Scene::emission_propagation () {
-	for (auto& source : sources) {
-		std::vector<Rayon> rays = source->genere_rayons();
-		stats_n_rayons_emis += rays.size();
+	if (propag_par_lots)
+		return this->emission_propagation_lots();
+	uint32_t frame = n_frame++;
+	auto t = std::chrono::steady_clock::now();
+	for (auto& objet : objets)
+		objet->pre_propagation();
+	if (propag_bvh)
+		bvh.construire(objets);
+	temps.bvh += chrono_tour(t);
+	
+	bool multi_thread = propag_n_threads > 1 and not propag_intercept_cb and not propag_emit_cb;
+#ifndef NOSFML
+	multi_thread = multi_thread and propag_intercept_dessin_window == nullptr;
+#endif
+	size_t n_threads = multi_thread ? propag_n_threads : 1;
+#ifndef NOSFML
+	this->dessin_rayons_preparer(n_threads);
+#endif
+	if (contextes_threads.size() < n_threads)
+		contextes_threads.resize(n_threads);
+	for (contexte_thread_t& ctx : contextes_threads) {
+		ctx.stats = {};
+#ifdef LIGHTRAYS_PROFIL
+		ctx.profil.assign(objets.size(), profil_objet_t{});
+#endif
+	}
+#ifdef LIGHTRAYS_PROFIL
+	profil.resize(objets.size(), profil_objet_t{});
+#endif
+	this->ecrans_do([&] (Ecran_Base& e) { e.preparer_threads(n_threads); });
+	if (fluence)
+		fluence->preparer_threads(n_threads);
+	
+	if (not multi_thread) {
+		for (uint32_t i_source = 0; i_source < sources.size(); i_source++) {
+			flux_alea_thread = flux_alea_t::cle(graine_alea, frame, i_source, UINT32_MAX);
+			std::vector<Rayon> rays = sources[i_source]->genere_rayons();
+			stats.n_rayons_emis += rays.size();
+			temps.emission += chrono_tour(t);
+			for (uint32_t k = 0; k < rays.size(); k++) {
+				if (propag_emit_cb)
+					propag_emit_cb(rays[k], 0);
+				flux_alea_thread = flux_alea_t::cle(graine_alea, frame, i_source, k);
+				this->propagation(rays[k], contextes_threads[0]);
+			}
+			temps.propagation += chrono_tour(t);
+		}
+		stats += contextes_threads[0].stats;
+#ifdef LIGHTRAYS_PROFIL
+		for (size_t i = 0; i < objets.size(); i++)
+			profil[i] += contextes_threads[0].profil[i];
+#endif
+		if (fluence)
+			fluence->commit();
+#ifndef NOSFML
+		this->dessin_rayons_terminer();
+#endif
+		return;
+	}
+	
+	if (not pool or pool->n_threads() != n_threads)
+		pool = std::make_unique<PoolThreads>(n_threads);
+	
+	// rayons primaires de toutes les sources, avec leur clé (source, indice dans la source) pour les flux aléatoires
+	std::vector<Rayon> rays;
+	std::vector<std::pair<uint32_t,uint32_t>> cles;
+	for (uint32_t i_source = 0; i_source < sources.size(); i_source++) {
+		flux_alea_thread = flux_alea_t::cle(graine_alea, frame, i_source, UINT32_MAX);
+		std::vector<Rayon> rays_source = sources[i_source]->genere_rayons();
+		for (uint32_t k = 0; k < rays_source.size(); k++)
+			cles.push_back({ i_source, k });
+		rays.insert(rays.end(), rays_source.begin(), rays_source.end());
+	}
+	stats.n_rayons_emis += rays.size();
+	temps.emission += chrono_tour(t);
+	
+	const size_t taille_paquet = 64;
+	std::atomic<size_t> i_paquet (0);
+	pool->executer([&] (size_t i_thread) {
+		size_t beg;
+		while ((beg = taille_paquet * i_paquet++) < rays.size()) {
+			size_t end = std::min(rays.size(), beg + taille_paquet);
+			for (size_t k = beg; k < end; k++) {
+				flux_alea_thread = flux_alea_t::cle(graine_alea, frame, cles[k].first, cles[k].second);
+				this->propagation(rays[k], contextes_threads[i_thread]);
+			}
+		}
+	});
+	for (size_t i = 0; i < n_threads; i++) {
+		stats += contextes_threads[i].stats;
+#ifdef LIGHTRAYS_PROFIL
+		for (size_t j = 0; j < objets.size(); j++)
+			profil[j] += contextes_threads[i].profil[j];
+#endif
+	}
+	temps.propagation += chrono_tour(t);
+	if (fluence)
+		fluence->commit();
+#ifndef NOSFML
+	this->dessin_rayons_terminer();
+#endif
+}
+
+// Propagation par lots de rayons de même profondeur. Pour chaque lot :
+//  1. test de profondeur maximale, les rayons restants sont les rayons « actifs »;
+//  2. pour chaque objet (par indice croissant), sélection des rayons actifs dont la boîte englobante
+//     de l'objet est traversée avant la plus proche interception déjà trouvée, puis test d'interception
+//     du lot sur ces seuls rayons;
+//  3. tri des rayons interceptés par objet, et ré-émission objet par objet; les rayons ré-émis
+//     d'intensité suffisante forment le lot suivant.
+//
+void Scene::emission_propagation_lots () {
+	contexte_lots_t& ctx = contexte_lots;
+	uint32_t frame = n_frame++;
+	auto t = std::chrono::steady_clock::now();
+	for (auto& objet : objets)
+		objet->pre_propagation();
+	this->ecrans_do([&] (Ecran_Base& e) { e.preparer_threads(1); });
+	if (fluence)
+		fluence->preparer_threads(1);
+#ifndef NOSFML
+	this->dessin_rayons_preparer(1);
+#endif
+	
+	ctx.boites.resize(objets.size());
+	for (size_t i = 0; i < objets.size(); i++) {
+		Objet::extension_t ext = objets[i]->objet_extension();
+		ctx.boites[i] = { ext.pos.x - ext.rayon, ext.pos.y - ext.rayon,
+		                  ext.pos.x + ext.rayon, ext.pos.y + ext.rayon };
+	}
+	temps.bvh += chrono_tour(t);
+#ifdef LIGHTRAYS_PROFIL
+	profil.resize(objets.size(), profil_objet_t{});
+#endif
+	
+	ctx.lot.vider();
+	for (uint32_t i_source = 0; i_source < sources.size(); i_source++) {
+		flux_alea_thread = flux_alea_t::cle(graine_alea, frame, i_source, UINT32_MAX);
+		std::vector<Rayon> rays = sources[i_source]->genere_rayons();
+		stats.n_rayons_emis += rays.size();
 		for (const Rayon& ray : rays) {
 			if (propag_emit_cb)
 				propag_emit_cb(ray, 0);
-			this->propagation_recur(ray, 0);
+			ctx.lot.ajouter(ray, 0);
 		}
 	}
+	temps.emission += chrono_tour(t);
+	
+	// propagation mono-thread dans un ordre fixé : un seul flux aléatoire pour la frame
+	flux_alea_thread = flux_alea_t::cle(graine_alea, frame, UINT32_MAX, UINT32_MAX);
+	while (ctx.lot.taille() != 0) {
+		LotRayons& lot = ctx.lot;
+		size_t n = lot.taille();
+		lot.calculer_directions();
+		
+		ctx.actifs.clear();
+		for (uint32_t k = 0; k < n; k++) {
+			stats.sum_prof_recur += lot.profondeur[k];
+			if (lot.profondeur[k] >= propag_profondeur_recur_max)
+				stats.n_rayons_profmax++;
+			else
+				ctx.actifs.push_back(k);
+		}
+		stats.n_rayons += ctx.actifs.size();
+		
+		ctx.intercepts.initialiser(n);
+		const float* ox = lot.orig_x.data();
+		const float* oy = lot.orig_y.data();
+		const float* inv_ux = lot.inv_u_x.data();
+		const float* inv_uy = lot.inv_u_y.data();
+		const float* t_min = ctx.intercepts.t.data();
+		for (uint32_t i = 0; i < objets.size(); i++) {
+			const BVH::boite_t b = ctx.boites[i];
+			ctx.candidats.clear();
+			for (uint32_t k : ctx.actifs) {
+				float t_entree = b.intersection(point_t{ ox[k], oy[k] }, vec_t{ inv_ux[k], inv_uy[k] });
+				if (t_entree != Inf and t_entree <= t_min[k])
+					ctx.candidats.push_back(k);
+			}
+			if (not ctx.candidats.empty()) {
+#ifdef LIGHTRAYS_PROFIL
+				// en mode par lots, une interception n'est connue que si elle est la plus proche au moment du test
+				auto t_essais = std::chrono::steady_clock::now();
+				objets[i]->essai_intercept_lot(lot, ctx.candidats, i, ctx.intercepts);
+				profil[i].temps_essais += chrono_tour(t_essais);
+				profil[i].n_essais += ctx.candidats.size();
+				for (uint32_t k : ctx.candidats)
+					profil[i].n_interceptions += (ctx.intercepts.i_objet[k] == i);
+#else
+				objets[i]->essai_intercept_lot(lot, ctx.candidats, i, ctx.intercepts);
+#endif
+			}
+		}
+		
+		// tri par dénombrement des rayons interceptés, par objet intercepteur
+		ctx.n_par_objet.assign(objets.size() + 1, 0);
+		for (uint32_t k : ctx.actifs)
+			if (ctx.intercepts.i_objet[k] != UINT32_MAX)
+				ctx.n_par_objet[ctx.intercepts.i_objet[k] + 1]++;
+		for (size_t i = 1; i <= objets.size(); i++)
+			ctx.n_par_objet[i] += ctx.n_par_objet[i-1];
+		ctx.ordre.resize(ctx.n_par_objet[objets.size()]);
+		for (uint32_t k : ctx.actifs)
+			if (ctx.intercepts.i_objet[k] != UINT32_MAX)
+				ctx.ordre[ ctx.n_par_objet[ctx.intercepts.i_objet[k]]++ ] = k;
+		
+		ctx.lot_suivant.vider();
+		for (uint32_t k : ctx.ordre) {
+			Objet& objet = *objets[ctx.intercepts.i_objet[k]];
+			Rayon ray = lot.rayon(k);
+			Objet::intercept_struct_t& intercept_struct = ctx.intercepts.intercept_struct[k];
+			if (not intercept_struct)
+				intercept_struct = objet.intercept_lot_struct(ray, ctx.intercepts.params[k]);
+			ctx.emis.clear();
+#ifdef LIGHTRAYS_PROFIL
+			bool chrono = (ctx.profil_compteur++ % profil_echantillonnage) == 0;
+			auto t_re_emit = chrono ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+			this->re_emission(objet, ray, intercept_struct, ctx.emis);
+			profil_objet_t& p = profil[ctx.intercepts.i_objet[k]];
+			if (chrono)
+				p.temps_re_emit += profil_echantillonnage * chrono_tour(t_re_emit);
+			p.n_retenues++;
+			p.n_rayons_emis += ctx.emis.size();
+#else
+			this->re_emission(objet, ray, intercept_struct, ctx.emis);
+#endif
+			uint16_t prof = lot.profondeur[k] + 1;
+			for (Rayon& r : ctx.emis) {
+				if (not this->test_intensite(r, stats))
+					continue;
+				if (propag_emit_cb)
+					propag_emit_cb(r, prof);
+				ctx.lot_suivant.ajouter(r, prof);
+			}
+		}
+		std::swap(ctx.lot, ctx.lot_suivant);
+	}
+	temps.propagation += chrono_tour(t);
+	if (fluence)
+		fluence->commit();
+#ifndef NOSFML
+	this->dessin_rayons_terminer();
+#endif
+}
+
+///------------------ Propagation jusqu'à convergence ------------------///
+
+float Scene::erreur_relative_ecrans () {
+	float err = 0;
+	this->ecrans_do([&] (Ecran_Base& e) { err = std::max(err, e.erreur_relative()); });
+	return err;
+}
+
+size_t Scene::propagation_convergence (float epsilon, size_t n_frames_max, size_t n_frames_min) {
+	size_t n_frames = 0;
+	while (n_frames < n_frames_max) {
+		this->emission_propagation();
+		this->ecrans_do([] (Ecran_Base& e) { e.commit(); });
+		n_frames++;
+		if (n_frames >= n_frames_min and this->erreur_relative_ecrans() < epsilon)
+			break;
+	}
+	return n_frames;
 }
 
 ///------- Méthodes utilitaires et Scene_ObjetsBougeables -------///
 
+#ifdef LIGHTRAYS_PROFIL
+
+Scene::profil_objet_t& Scene::profil_objet_t::operator+= (const profil_objet_t& o) {
+	n_essais += o.n_essais;
+	n_interceptions += o.n_interceptions;
+	n_retenues += o.n_retenues;
+	n_rayons_emis += o.n_rayons_emis;
+	temps_essais += o.temps_essais;
+	temps_re_emit += o.temps_re_emit;
+	return *this;
+}
+
+Scene::profil_objet_t Scene::profil_objet (const Objet& objet) const {
+	for (size_t i = 0; i < objets.size() and i < profil.size(); i++)
+		if (objets[i].get() == &objet)
+			return profil[i];
+	return {};
+}
+
+// Tableau du profil : une ligne par objet, par temps (essais + ré-émissions) décroissant,
+//  avec la part de ce temps dans le total de tous les objets
+//
+void Scene::profil_tableau (std::ostream& os) const {
+	std::vector<size_t> ordre;
+	double temps_tot = 0;
+	for (size_t i = 0; i < objets.size() and i < profil.size(); i++) {
+		ordre.push_back(i);
+		temps_tot += profil[i].temps_essais + profil[i].temps_re_emit;
+	}
+	auto temps = [&] (size_t i) { return profil[i].temps_essais + profil[i].temps_re_emit; };
+	std::stable_sort(ordre.begin(), ordre.end(), [&] (size_t i, size_t j) { return temps(i) > temps(j); });
+	
+	auto nom_type = [] (const Objet& objet) -> std::string {
+		int status;
+		char* nom = abi::__cxa_demangle(typeid(objet).name(), nullptr, nullptr, &status);
+		std::string s = (status == 0) ? nom : typeid(objet).name();
+		free(nom);
+		return s;
+	};
+	
+	os << std::left << std::setw(5) << "i" << std::setw(32) << "objet" << std::right
+	   << std::setw(12) << "essais" << std::setw(12) << "intercept" << std::setw(12) << "retenues"
+	   << std::setw(12) << "rayons" << std::setw(12) << "essais ms" << std::setw(12) << "re_emit ms"
+	   << std::setw(8) << "%" << std::endl;
+	os << std::fixed;
+	for (size_t i : ordre) {
+		const profil_objet_t& p = profil[i];
+		os << std::left << std::setw(5) << i << std::setw(32) << nom_type(*objets[i]).substr(0,31) << std::right
+		   << std::setw(12) << p.n_essais << std::setw(12) << p.n_interceptions << std::setw(12) << p.n_retenues
+		   << std::setw(12) << p.n_rayons_emis
+		   << std::setw(12) << std::setprecision(2) << 1e3*p.temps_essais << std::setw(12) << 1e3*p.temps_re_emit
+		   << std::setw(8) << std::setprecision(1) << (temps_tot > 0 ? 100*temps(i)/temps_tot : 0.) << std::endl;
+	}
+	os << std::defaultfloat;
+}
+
+#endif
+
 void Scene::ecrans_do (std::function<void (Ecran_Base &)> f) {
 	for (auto obj : objets) {
 		Ecran_Base* ecran = dynamic_cast<Ecran_Base*>(obj.get());
@@ -90,6 +516,22 @@ void Scene::ecrans_do (std::function<void (Ecran_Base &)> f) {
 	}
 }
 
+#ifndef NOSFML
+
+void Scene::dessin_rayons_preparer (size_t n_threads) {
+	if (propag_rayons_dessin_lignes.size() < n_threads)
+		propag_rayons_dessin_lignes.resize(n_threads, sf::VertexArray(sf::Lines));
+	for (sf::VertexArray& lignes : propag_rayons_dessin_lignes)
+		lignes.clear();
+}
+
+void Scene::dessin_rayons_terminer () {
+	if (propag_rayons_dessin_window != nullptr) {
+		for (const sf::VertexArray& lignes : propag_rayons_dessin_lignes)
+			propag_rayons_dessin_window->draw(lignes);
+	}
+}
+
 bool Scene_ObjetsBougeables::objetsBougeables_event_SFML (const sf::Event& event) {
 	if (objet_bougeant == nullptr) {
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::LShift)
@@ -138,3 +580,5 @@ void Scene_ObjetsBougeables::dessiner_pointeur_nearest_bougeable (sf::RenderWind
 		win.draw(pointeur);
 	}
 }
+
+#endif
@@ -9,11 +9,20 @@
 
 #include <vector>
 #include <memory>
+#include <ostream>
+#include <functional>
+#include <cstdint>
 #include "Objet.h"
 #include "Source.h"
 #include "Ecran.h"
+#include "Fluence.h"
+#include "BVH.h"
+#include "PoolThreads.h"
+#ifndef NOSFML
 #include <SFML/Window/Event.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+#endif
 
 class Scene {
 public:
@@ -36,46 +45,172 @@ public:
 	
 		///--------- Routines de propagation des rayons ---------///
 	
+#ifndef NOSFML
 	// Fenêtre de dessin des interceptions et/ou rayons (voir Scene::interception_re_emission)
 	sf::RenderWindow* propag_intercept_dessin_window = nullptr;
 	sf::RenderWindow* propag_rayons_dessin_window = nullptr;
 	float propag_rayons_dessin_gain = 10.;
+	// Segments des rayons à dessiner dans `propag_rayons_dessin_window`, un tableau par thread de propagation,
+	//  accumulés pendant la propagation puis dessinés en un appel par thread à la fin de la frame
+	std::vector<sf::VertexArray> propag_rayons_dessin_lignes;
+	void dessin_rayons_preparer (size_t n_threads);
+	void dessin_rayons_terminer ();
+#endif
 	
 	// Callback appelé lors de l'interception d'un rayon par un objet. Utilisation typique : déboguage.
 	// `intercept_struct` est le Objet::intercept_t::intercept_struct renvoyé par Objet::essai_intercept
-	std::function< void (Objet&, const Rayon&, std::shared_ptr<void> intercept_struct) > propag_intercept_cb = nullptr;
+	std::function< void (Objet&, const Rayon&, const Objet::intercept_struct_t& intercept_struct) > propag_intercept_cb = nullptr;
 	// Callback appellé pour chaque rayon émis ou ré-émis
 	std::function< void (const Rayon&, uint16_t prof_recur) > propag_emit_cb = nullptr;
 	
-	// Statistiques
-	uint64_t stats_n_rayons, stats_n_rayons_profmax, stats_n_rayons_discarded, stats_sum_prof_recur, stats_n_rayons_emis;
+	// Carte de fluence optionnelle : chaque rayon intercepté y ajoute son segment (de son origine à son
+	//  point d'interception, voir `Objet::point_interception`). Fusionnée (`commit`) à la fin de chaque
+	//  `emission_propagation`; la réinitialisation (`reset`) est laissée à l'utilisateur, comme pour les écrans.
+	std::shared_ptr<CarteFluence> fluence;
+	
+	// Hiérarchie de volumes englobants des objets, reconstruite à chaque `emission_propagation` à partir
+	//  des `Objet::objet_extension()`. Si `propag_bvh` est faux (ou si l'arbre n'est pas à jour), le rayon
+	//  est testé contre tous les objets de la scène.
+	bool propag_bvh = true;
+	BVH bvh;
+	
+	// Statistiques, cumulées sur toutes les frames jusqu'à réinitialisation par l'utilisateur (`stats = {}`)
+	struct stats_t {
+		uint64_t n_rayons, n_rayons_profmax, n_rayons_discarded, sum_prof_recur, n_rayons_emis;
+		// intensité totale des rayons abandonnés (coupure ou roulette russe), et intensité ajoutée
+		//  aux rayons ayant survécu à la roulette russe (égales en moyenne)
+		double intens_jetee, intens_roulette;
+		stats_t& operator+= (const stats_t& o);
+	};
+	stats_t stats = {};
+	
+	// Temps de calcul (en secondes), cumulés comme `stats` : construction du BVH, génération des rayons
+	//  primaires par les sources, et propagation (interceptions et ré-émissions)
+	struct temps_t {
+		double bvh, emission, propagation;
+	};
+	temps_t temps = {};
+	
+	// Nombre de threads de propagation. Si > 1, les rayons primaires de toutes les sources sont répartis
+	//  sur les threads de `pool`; chaque thread a ses propres statistiques (sommées dans `stats` à la fin
+	//  de `emission_propagation`) et ses propres accumulateurs d'écrans (voir Ecran_Base::preparer_threads).
+	// Le dessin des interceptions et les callbacks n'étant pas thread-safe, la propagation reste
+	//  mono-thread si `propag_intercept_dessin_window` ou `propag_*_cb` sont définis (le dessin des rayons,
+	//  différé à la fin de la frame, est compatible avec la propagation multi-thread).
+	size_t propag_n_threads = 1;
+	std::unique_ptr<PoolThreads> pool;
+	
+	// Nombres aléatoires : graine de la scène et numéro de la frame courante (incrémenté à chaque
+	//  `emission_propagation`), qui avec l'indice de la source et du rayon primaire forment la clé du
+	//  flux aléatoire (voir `flux_alea_t`). Résultats reproductibles quel que soit le nombre de threads.
+	uint64_t graine_alea = 1;
+	uint32_t n_frame = 0;
+	
+#ifdef LIGHTRAYS_PROFIL
+	// Profil par objet, compilé seulement avec -DLIGHTRAYS_PROFIL : nombre de tests d'interception
+	//  (`essai_intercept`), d'interceptions trouvées, d'interceptions retenues (les plus proches, chacune
+	//  suivie d'un appel à `re_emit`), de rayons ré-émis, et temps passé (s) dans `essai_intercept` et `re_emit`.
+	// `profil[i]` correspond à `objets[i]`; cumulé sur les frames comme `stats` (réinitialisation : `profil.clear()`).
+	// Pour limiter le coût de la mesure, seul un rayon sur `profil_echantillonnage` est chronométré (les temps
+	//  sont extrapolés), les compteurs sont exacts.
+	static constexpr uint32_t profil_echantillonnage = 16;
+	struct profil_objet_t {
+		uint64_t n_essais, n_interceptions, n_retenues, n_rayons_emis;
+		double temps_essais, temps_re_emit;
+		profil_objet_t& operator+= (const profil_objet_t& o);
+	};
+	std::vector<profil_objet_t> profil;
+	// Profil de l'objet `objet`, nul si l'objet n'est pas dans la scène
+	profil_objet_t profil_objet (const Objet& objet) const;
+	// Tableau du profil de tous les objets, par temps total décroissant
+	void profil_tableau (std::ostream& os) const;
+#endif
+	
+	// Contexte de propagation propre à chaque thread : statistiques de la frame, pile des rayons
+	//  restant à propager, et tampon des rayons ré-émis par une interception (`Objet::re_emit`).
+	//  La mémoire des deux tampons est réutilisée d'une interception et d'une frame à l'autre.
+	struct rayon_pile_t { Rayon ray; uint16_t profondeur; };
+	struct contexte_thread_t {
+		stats_t stats;
+		std::vector<rayon_pile_t> pile;
+		std::vector<Rayon> emis;
+#ifdef LIGHTRAYS_PROFIL
+		std::vector<profil_objet_t> profil;
+		uint32_t profil_compteur = 0;
+#endif
+	};
+	std::vector<contexte_thread_t> contextes_threads;
 	
 	// Test d'interception du rayon contre toutes les objets de la scène puis ré-émission; la première
-	//  interception sur le trajet du rayon depuis son origine est choisie. Renvoie tous les rayons ré-émis.
+	//  interception sur le trajet du rayon depuis son origine est choisie. Ajoute les rayons ré-émis à `sortie`.
 	// Si `propagation_params.window` ≠ null, dessine l'interception du rayon avec `objet.dessiner_interception`,
 	//  et appelle `propag_intercept_cb` (par exemple pour un dessin du rayon de la source à l'objet) si ≠ null.
 	// Si `propag_rayons_dessin_window` ≠ null, dessine les rayons en blanc transparent (∝ intensité) grâce
-	//  à `objet.point_interception`. Méthode surtout interne, appelé par `propagation_recur`.
-	std::vector<Rayon> interception_re_emission (const Rayon& ray);
+	//  à `objet.point_interception`. Méthode surtout interne, appelé par `propagation`.
+	void interception_re_emission (const Rayon& ray, std::vector<Rayon>& sortie);
+	// Ré-émission du rayon `ray` intercepté par `objet`, avec dessin et callback comme ci-dessus
+	void re_emission (Objet& objet, const Rayon& ray, const Objet::intercept_struct_t& intercept_struct, std::vector<Rayon>& sortie);
 	
-		/// Propagation d'un rayon : récursion de l'interception/ré-émission
+		/// Propagation d'un rayon : répétition de l'interception/ré-émission
 	
 	// Intensité en dessous de laquelle un rayon est ignoré. Fort impact sur la performance
 	float intens_cutoff = 1e-2;
-	// Profondeur de récursion (= nombre de ré-émission d'un rayon initial) maximale
+	// Roulette russe : au lieu d'être ignoré, un rayon ré-émis d'intensité I < `intens_cutoff` survit avec
+	//  la probabilité I/intens_cutoff, son intensité étant alors portée à `intens_cutoff`. L'énergie arrivant
+	//  sur les écrans est ainsi non biaisée, et `intens_cutoff` peut être élevé sans assombrir l'image.
+	bool propag_roulette = false;
+	// Profondeur de récursion (= nombre de ré-émissions depuis le rayon initial) maximale
 	// Ne devrait jouer que pour des réflexions infinies sans perte (où l'intensité ne passe jamais en dessous de `intens_cutoff`)
 	uint16_t propag_profondeur_recur_max = 20;
 	
-	// Fonction récurrente : interception par les objets de la scène puis ré-émission;
+	// Propagation d'un rayon primaire et de tous ses descendants : interception par les objets de la scène
+	//  puis ré-émission, en profondeur d'abord (même ordre qu'une récursion), avec la pile `ctx.pile`;
 	//  utilise `interception_re_emission`, `intens_cutoff` et `propag_profondeur_recur_max`.
-	// Appelle `propag_emit_cb` si ≠ null. Méthode surtout interne, appelé par `emission_propagation`.
-	void propagation_recur (const Rayon& ray, uint16_t profondeur_recur);
+	// Appelle `propag_emit_cb` si ≠ null pour les rayons ré-émis. Les statistiques sont accumulées dans `ctx.stats`.
+	// Méthode surtout interne, appelé par `emission_propagation`.
+	void propagation (const Rayon& ray, contexte_thread_t& ctx);
+	// Test d'intensité d'un rayon ré-émis, selon `intens_cutoff` et `propag_roulette` : renvoie faux si le
+	//  rayon est abandonné, sinon le rayon est propagé (et son intensité éventuellement ré-évaluée)
+	bool test_intensite (Rayon& ray, stats_t& stats);
 	
-	// Fonction principale : émet les rayons de toutes les sources de la scène et appelle `propagation_recur`.
+	// Fonction principale : construit `bvh`, émet les rayons de toutes les sources de la scène et appelle
+	//  `propagation`, sur `propag_n_threads` threads si possible.
 	void emission_propagation ();
 	
+		/// Propagation par lots (« wavefront »)
+	
+	// Si vrai, `emission_propagation` propage les rayons par lots de même profondeur plutôt que rayon par
+	//  rayon : tous les rayons du lot sont testés objet par objet (`Objet::essai_intercept_lot`, après un
+	//  test de boîte englobante), puis ré-émis regroupés par objet intercepteur, et les rayons ré-émis
+	//  forment le lot suivant. Les lignes, arcs et objets composites ont un test par lots; Objet_Brouillard
+	//  est testé rayon par rayon. Toujours mono-thread; l'ordre des tirages aléatoires diffère de la propagation
+	//  en profondeur, les résultats sont donc statistiquement (et non exactement) identiques.
+	bool propag_par_lots = false;
+	struct contexte_lots_t {
+		LotRayons lot, lot_suivant;
+		Objet::intercept_lot_t intercepts;
+		std::vector<Rayon> emis;
+		std::vector<BVH::boite_t> boites; // boîtes englobantes des objets pour la frame
+		std::vector<uint32_t> actifs, candidats, ordre, n_par_objet;
+#ifdef LIGHTRAYS_PROFIL
+		uint32_t profil_compteur = 0;
+#endif
+	};
+	contexte_lots_t contexte_lots;
+	void emission_propagation_lots ();
+	
+		/// Propagation jusqu'à convergence
+	
+	// Plus grande erreur relative des écrans de la scène (voir Ecran_Base::erreur_relative)
+	float erreur_relative_ecrans ();
+	// Propagation de frames (`emission_propagation` puis `commit` des écrans) jusqu'à ce que l'erreur relative
+	//  de tous les écrans soit inférieure à `epsilon` (après au moins `n_frames_min` frames, pour que l'estimation
+	//  de l'erreur soit fiable), ou jusqu'à `n_frames_max` frames. Renvoie le nombre de frames propagées.
+	size_t propagation_convergence (float epsilon, size_t n_frames_max, size_t n_frames_min = 10);
+	
 		///--------- Affichage et interface utilisateur ---------///
 	
+#ifndef NOSFML
 	// Dessin de tous les objets et sources de la scène.
 	void dessiner_scene (sf::RenderWindow& window) const {
 		for (auto& objet : objets)
@@ -83,12 +218,15 @@ public:
 		for (auto& source : sources)
 			source->dessiner(window);
 	}
+#endif
 	
 	// Appelle f() sur tous les objets de type Ecran_Base
 	void ecrans_do (std::function<void(Ecran_Base&)> f);
 	
 };
 
+#ifndef NOSFML
+
 ///----------------------------------------------------------------------
 /// Scène avec objets "bougeables" : routines utiles pour (par exemple)
 ///  déplacer/tourner les objets de la scène avec la souris, suivant des
@@ -127,3 +265,5 @@ public:
 };
 
 #endif
+
+#endif
@@ -2,14 +2,16 @@
 #include <sstream>
 #include <iomanip>
 #include <unistd.h>
+#include <future>
 
 // Création de la scène, des fenêtres SFML, et optionnellement
 //  de l'écran, de la fenêtre, et de la lentille image
 //
 Scene_TestCommon::Scene_TestCommon (std::wstring nom, bool creer_ecran_image, bool creer_lentille_image) :
-	win_scene(nullptr), nom(nom), reset_ecrans(false), frame_i(0), gel(false), affiche_text(true), win_pixels(nullptr) {
+	win_scene(nullptr), nom(nom), reset_ecrans(false), frame_i(0), gel(false), affiche_text(true), win_pixels(nullptr), stats_affich{}, erreur_affich(Inf) {
 	intens_cutoff = 1e-3;
 	propag_profondeur_recur_max = 50;
+	propag_n_threads = std::max(1u, std::thread::hardware_concurrency());
 		
 	// Création des fenêtres SFML
 	sf::ContextSettings settings;
@@ -70,7 +72,7 @@ Scene_TestCommon::~Scene_TestCommon () {
 
 // Boucle principale SFML :
 //  - traite les évènements
-//  - effectue la propagation des rayons
+//  - effectue la propagation des rayons, en tâche de fond pendant le dessin si possible
 //  - dessine la scène, gère et affiche les statistiques, gère les écrans
 //
 void Scene_TestCommon::boucle (std::function<void(sf::Event)> f_event,
@@ -131,19 +133,11 @@ void Scene_TestCommon::boucle (std::function<void(sf::Event)> f_event,
 			continue;
 		}
 		
-		// Dessin des objets de la scène avant propagation
-		win_scene->clear(sf::Color::Black);
-		this->dessiner_scene(*win_scene);
-		
 		if (f_pre_propag)
 			f_pre_propag();
 		
 		// Reset statistiques et écrans
-		stats_n_rayons_emis = 0;
-		stats_n_rayons = 0;
-		stats_sum_prof_recur = 0;
-		stats_n_rayons_profmax = 0;
-		stats_n_rayons_discarded = 0;
+		stats = {};
 		
 		if (reset_ecrans) {
 			this->ecrans_do([] (Ecran_Base& e) { e.reset(); });
@@ -151,24 +145,48 @@ void Scene_TestCommon::boucle (std::function<void(sf::Event)> f_event,
 			frame_i = 0;
 		}
 		
-		// Émission et propagation des rayons
-		this->emission_propagation();
-		this->ecrans_do([] (Ecran_Base& e) { e.commit(); });
+		// Émission et propagation des rayons, puis commit des écrans (publication de leurs instantanés)
+		auto propagation_frame = [this] () {
+			this->emission_propagation();
+			this->ecrans_do([] (Ecran_Base& e) { e.commit(); });
+		};
+		auto fin_frame = [this] () {
+			stats_affich = stats;
+			erreur_affich = this->erreur_relative_ecrans();
+		};
+		
+		// Sans dessin pendant la propagation ni callbacks, la propagation de la frame a lieu en tâche de fond
+		//  pendant que la scène et les instantanés des écrans (frame précédente) sont dessinés et affichés
+		std::future<void> propag_fond;
+		bool pipeline = propag_rayons_dessin_window == nullptr and propag_intercept_dessin_window == nullptr
+		                and not propag_intercept_cb and not propag_emit_cb;
+		if (pipeline)
+			propag_fond = std::async(std::launch::async, propagation_frame);
+		
+		// Dessin des objets de la scène (avant propagation si elle n'est pas en tâche de fond)
+		win_scene->clear(sf::Color::Black);
+		this->dessiner_scene(*win_scene);
+		if (not pipeline) {
+			propagation_frame();
+			fin_frame();
+		}
 		
 		if (f_post_propag)
 			f_post_propag();
 		
 		// Affichage de la matrice de pixels dans la fenêtre image
 		if (win_pixels != nullptr) {
-			std::vector<EcranLigne_Multi::pixel_t> pix = ecran_image->matrice_pixels();
-			sf::RectangleShape rect;
-			rect.setSize(sf::Vector2f( 100, 400./pix.size() ));
+			const std::vector<EcranLigne_Multi::pixel_t>& pix = ecran_image->matrice_pixels();
+			sf::VertexArray rects (sf::Quads, 4 * pix.size());
 			for (size_t k = 0; k < pix.size(); k++) {
 				auto color = sf::Color(pix[k].r, pix[k].g, pix[k].b);
-				rect.setPosition(sf::Vector2f( 0, k * 400./pix.size() ));
-				rect.setFillColor(color);
-				win_pixels->draw(rect);
+				float y1 = k * 400./pix.size(), y2 = (k+1) * 400./pix.size();
+				rects[4*k+0] = sf::Vertex(sf::Vector2f(  0, y1), color);
+				rects[4*k+1] = sf::Vertex(sf::Vector2f(100, y1), color);
+				rects[4*k+2] = sf::Vertex(sf::Vector2f(100, y2), color);
+				rects[4*k+3] = sf::Vertex(sf::Vector2f(  0, y2), color);
 			}
+			win_pixels->draw(rects);
 			win_pixels->display();
 			while (win_pixels->pollEvent(event)) {}
 		}
@@ -178,12 +196,18 @@ void Scene_TestCommon::boucle (std::function<void(sf::Event)> f_event,
 		
 		// Affichage de l'aide et des statistiques
 		if (affiche_text) {
+			const stats_t& stats = stats_affich;
 			std::wstringstream text;
 			for (auto& s : static_text)
 				text << s << std::endl;
 			text << std::endl;
-			text << frame_i << L" frame accumulées" << std::endl;
-			text << stats_n_rayons_emis << " rayons primaires, " << stats_n_rayons << " rayons tot, " << std::fixed << std::setprecision(1) << (stats_sum_prof_recur/(float)stats_n_rayons) << " prof recur moy, " << stats_n_rayons_discarded << L" rayons jetés, " << stats_n_rayons_profmax << " max prof" << std::endl;
+			text << frame_i << L" frame accumulées, erreur relative " << std::setprecision(2) << 100*erreur_affich << "%" << std::endl;
+			text << stats.n_rayons_emis << " rayons primaires, " << stats.n_rayons << " rayons tot, " << std::fixed << std::setprecision(1) << (stats.sum_prof_recur/(float)stats.n_rayons) << " prof recur moy, " << stats.n_rayons_discarded << L" rayons jetés, " << stats.n_rayons_profmax << " max prof";
+			if (propag_n_threads > 1)
+				text << ", " << propag_n_threads << " threads" << (propag_intercept_dessin_window != nullptr ? L" (inactifs pendant le dessin des interceptions)" : L"");
+			if (pipeline)
+				text << L", en tâche de fond";
+			text << std::endl;
 			text << std::setprecision(3) << "pointeur : (" << mouse.x << "," << mouse.y << ")";
 			win_scene->draw( sf::c01::buildText(font, point_t{0.1f,0.015f*(8+static_text.size())}, {text.str()}, sf::Color::White) );
 			
@@ -193,8 +217,13 @@ void Scene_TestCommon::boucle (std::function<void(sf::Event)> f_event,
 				win_scene->draw( sf::c01::buildText(font, this->lentille->b+vec2_t{-0.03,0}, {L"Lentille"}, sf::Color::White) );
 		}
 		
-		// Affichage SFML
+		// Affichage SFML, puis fin de la propagation en tâche de fond (les évènements ne sont traités, et la
+		//  scène modifiée, qu'entre deux propagations)
 		win_scene->display();
+		if (pipeline) {
+			propag_fond.get();
+			fin_frame();
+		}
 		frame_i++;
 	}
 }
@@ -22,6 +22,8 @@
 #include "sfml_c01.hpp"
 #include <string>
 #include <vector>
+#include <functional>
+#include <cstdint>
 
 class Scene_TestCommon : public Scene_ObjetsBougeables {
 public:
@@ -37,6 +39,8 @@ public:
 	sf::RenderWindow* win_pixels; // fenêtre SFML secondaire optionnelle pour affichage de l'image sur l'écran `ecran_image`
 	std::shared_ptr<EcranLigne_Multi> ecran_image; // écran de formation d'images (si `win_pixels!=null`)
 	std::shared_ptr<Objet_MatriceTrsfUnidir> lentille; // lentille convergente pour former les images, optionnelle (et si `win_pixels!=null`)
+	stats_t stats_affich; // statistiques de la dernière frame propagée, affichées
+	float erreur_affich; // erreur relative des écrans (voir Scene::erreur_relative_ecrans) à la dernière frame propagée
 	void lentille_mise_au_point (float x_obj); // mise au point de la lentille sur le plan x = `x_obj`
 	void creer_bloqueurs_autour_lentille (float taille);
 	
@@ -51,6 +55,11 @@ public:
 	//     appelle (optionnel) `f_pre_propag`; et après cela, appelle (optionnel) `f_post_propag`
 	//  - dessine la scène
 	//  - gère et affiche les statistiques, gère les écrans
+	// Si les rayons ne sont pas dessinés pendant la propagation (`propag_*_dessin_window` nuls) et sans callbacks
+	//  `propag_*_cb`, la propagation se fait en tâche de fond pendant le dessin et l'affichage, qui montrent alors
+	//  la frame précédente (instantanés des écrans, voir TamponTriple) : `f_post_propag` est appelé pendant la
+	//  propagation de la frame suivante et ne doit lire les écrans que par leurs instantanés. Les évènements,
+	//  `f_event` et `f_pre_propag` sont traités entre deux propagations et peuvent modifier la scène.
 	void boucle (std::function<void(sf::Event)> f_event,
 				 std::function<void(void)> f_pre_propag,
 				 std::function<void(void)> f_post_propag);
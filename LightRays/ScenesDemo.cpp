@@ -0,0 +1,195 @@
+#include "ScenesDemo.h"
+#include "ObjetsOptiques.h"
+#include "ObjetDiffusant.h"
+#include "ObjetMilieux.h"
+#include "Brouillard.h"
+#include <cmath>
+
+///------------------------ Éléments communs ------------------------///
+
+// Mêmes éléments que dans Scene_TestCommon, sans fenêtre ni objets bougeables
+namespace {
+
+	// Largeur de la scène : celle de la fenêtre des scènes test (1100 pixels pour 720 pixels par unité)
+	const float scene_largeur = 1100.f / 720;
+
+	std::shared_ptr<Source_UniqueRayon> creer_source_unique_rayon (Scene& scene, point_t pos, float dir_angle, float ampl) {
+		auto source = std::make_shared<Source_UniqueRayon>(pos, dir_angle, (color_id_t)0, ampl);
+		scene.sources.push_back(source);
+		return source;
+	}
+
+	std::shared_ptr<Source_PonctOmni> creer_source_omni_secteur (Scene& scene, point_t pos, float ang_ext, float ang_base, float dens_ray) {
+		auto source = std::make_shared<Source_PonctOmni>(pos, spectre_blanc);
+		source->dens_ang = dens_ray;
+		source->dir_alea = true;
+		source->secteur = angle_interv_t(-ang_ext,+ang_ext) + ang_base;
+		scene.sources.push_back(source);
+		return source;
+	}
+
+	std::shared_ptr<Source_LinLambertien> creer_ciel_bleu (Scene& scene, float dens_lin = 1000) {
+		auto ciel = std::make_shared<Source_LinLambertien>(
+			/*a*/point_t{0.05,0.05}, /*segment*/vec_t{0,0.90},
+			Specte::polychromatique({{0,0,1.1,2}})
+		);
+		ciel->dens_lin = dens_lin;
+		scene.sources.push_back(ciel);
+		return ciel;
+	}
+
+	void creer_ecrans_autour (Scene& scene, float lumino, float a) {
+		float b = scene_largeur;
+		float bin_density = 50;
+		scene.creer_objet<EcranLigne_Multi>( point_t{  a,   a}, point_t{b-a,   a}, bin_density, lumino )->epaisseur_affich = a;
+		scene.creer_objet<EcranLigne_Multi>( point_t{b-a,   a}, point_t{b-a, 1-a}, bin_density, lumino )->epaisseur_affich = a;
+		scene.creer_objet<EcranLigne_Multi>( point_t{b-a, 1-a}, point_t{  a, 1-a}, bin_density, lumino )->epaisseur_affich = a;
+		scene.creer_objet<EcranLigne_Multi>( point_t{  a, 1-a}, point_t{  a,   a}, bin_density, lumino )->epaisseur_affich = a;
+	}
+
+	// Écran image, et lentille mise au point sur le plan x = `x_obj` si `x_obj` est fini
+	void creer_ecran_image (Scene& scene, float x_obj) {
+		if (std::isfinite(x_obj)) {
+			float f = -1 / ( 1/(1.5-1.2) + 1/(1.2-x_obj) );
+			scene.creer_objet<Objet_MatriceTrsfUnidir>( point_t{1.2,0.5}, 0.2, 0, Objet_MatriceTrsfUnidir::mat_trsf_lentille(f) );
+		}
+		scene.creer_objet<EcranLigne_Multi>( point_t{1.5,0.45}, point_t{1.5,0.55}, (uint16_t)200, 0.0001 );
+	}
+
+}
+
+///------------------------ Scènes ------------------------///
+
+// Store d'arcs de cercles diffusants (main_store.cpp)
+//
+static void scene_demo_store (Scene& scene) {
+	creer_ecrans_autour(scene, /*lumino*/0.001, /*épaisseur*/0.02);
+	creer_ciel_bleu(scene);
+	auto soleil = std::make_shared<Source_LinParallels>(point_t{0.1,0.65}, vec_t{0,0.3}, /*dir_angle*/-0.15*M_PI, spectre_blanc);
+	soleil->dens_lin = 6000;
+	scene.sources.push_back(soleil);
+	for (float y = 0.4; y < 0.95; y += 0.03) {
+		auto arc = scene.creer_objet<ObjetArc_Diffusant>(
+			ObjetCourbe_Diffusant::BRDF_Lambert,
+			/*centre*/point_t{0.3,y}, /*rayon*/0.04, angle_interv_t(M_PI/4,M_PI/2), /*inv_int*/false
+		);
+		arc->n_re_emit_par_intens = 1;
+	}
+	auto sol = scene.creer_objet<ObjetLigne_Diffusant>(ObjetCourbe_Diffusant::BRDF_Lambert, point_t{0.3,0.3}, point_t{2,0.3});
+	sol->n_re_emit_par_intens = 1;
+}
+
+// Surface diffusante lambertienne + spéculaire en cos^n, et bilan d'énergie (main_diffus_test.cpp)
+//
+static void scene_demo_diffus (Scene& scene) {
+	creer_ecran_image(scene, /*x_obj*/0.5);
+	creer_ecrans_autour(scene, /*lumino*/0.0005, /*épaisseur*/0.025);
+	auto source_omni = creer_source_omni_secteur(scene, point_t{0.3,0.66}, /*ang_ext*/0.1, /*ang_base*/-0.22*M_PI, /*dens_ray*/60000);
+	auto panel_diffus = scene.creer_objet<ObjetLigne_Diffusant>(ObjetCourbe_Diffusant::BRDF_Lambert, point_t{0.45,0.51}, point_t{0.55,0.49});
+	// source pointée vers le centre du plan diffusant
+	vec_t v = milieu_2points(panel_diffus->a,panel_diffus->b) - source_omni->position;
+	source_omni->secteur = angle_interv_t(-0.1,+0.1) + atan2f(v.y,v.x);
+	// réflexion en cos^3, normalisée (voir main_diffus_test.cpp)
+	const int diffus_n = 3;
+	const float diffus_c = 2 * (diffus_n-1.f) / diffus_n;
+	const float refl_spec = 1;
+	panel_diffus->BRDF_lambda = [=] (float theta_i, float theta_r, float lambda) -> float {
+		float f_col = (lambda-4.5e-4)/1e-4; f_col = expf(-f_col*f_col);
+		return f_col * (1-refl_spec)  +  refl_spec * M_PI * powf( std::max(0.f, cosf(theta_i+theta_r)), diffus_n) / diffus_c;
+	};
+	scene.creer_objet<Objet_BilanEnergie>(point_t{0.5,0.5}, 0.2);
+	scene.creer_objet<Objet_Bloqueur>(point_t{1.3,0.53}, point_t{1.3,0.6});
+	scene.creer_objet<Objet_Bloqueur>(point_t{1.3,0.47}, point_t{1.3,0.4});
+}
+
+// Réflexion, réfraction, dispersion, lentille épaisse, miroir, filtre et prisme (main_milieux.cpp)
+//
+static void scene_demo_milieux (Scene& scene) {
+	creer_ecran_image(scene, /*sans lentille*/Inf);
+	creer_ecrans_autour(scene, /*lumino*/0.001, /*épaisseur*/0.02);
+	auto source_unique = creer_source_unique_rayon(scene, point_t{0.1,0.3}, /*dir*/0, /*ampl*/400.);
+	source_unique->spectre = Specte::polychromatique({{8,8,17,22}});
+	creer_source_omni_secteur(scene, point_t{0.34722,0.50972}, /*ang_ext*/0.1, /*ang_base*/0, 10000);
+	// lame
+	std::vector<point_t> pts = { {0,0}, {0.2,0}, {0.2,0.03}, {0,0.03} };
+	pts = rotate_points({0.2,0.1}, 0.4*M_PI, pts);
+	pts = translate_points({0.2,0.35}, pts);
+	scene.creer_objet<ObjetComposite_LignesMilieu>(pts, 2.4);
+	// dioptre à indice variable
+	std::function<float(float)> indice_refr_lambda = [] (float lambda) {
+		return 1 + 0.1 * lambda / lambda_color[N_COULEURS/2];
+	};
+	scene.creer_objet<ObjetLigne_Milieux>(indice_refr_lambda, point_t{0.8,0.25}, point_t{0.85,0.35});
+	// lentille réelle convergente et diaphragme
+	scene.creer_objet<ObjetArc_Milieux>( 1.7, point_t{1.2,0.4}, point_t{1.2,0.6}, 0.3, false );
+	scene.creer_objet<ObjetArc_Milieux>( 1.7, point_t{1.2,0.6}, point_t{1.2,0.4}, 0.3, false );
+	scene.creer_objet<Objet_Bloqueur>(point_t{1.3,0.52}, point_t{1.3,0.6});
+	scene.creer_objet<Objet_Bloqueur>(point_t{1.3,0.48}, point_t{1.3,0.4});
+	// miroir et filtre
+	scene.creer_objet<ObjetLigne_Miroir>(point_t{0.2,0.45}, point_t{0.2,0.55});
+	scene.creer_objet<Objet_Filtre>(couleur_proche(5.3e-4), point_t{0.1,0.8}, point_t{0.2,0.8});
+	// prisme
+	const std::vector<point_t> pts_triangle = { {1,0}, {cosf(2*M_PI/3),sinf(2*M_PI/3)}, {cosf(-2*M_PI/3),sinf(-2*M_PI/3)} };
+	auto pts_tri = homothetie_points({0,0}, /*taille*/0.1, pts_triangle);
+	pts_tri = translate_points(vec_t{0.5,0.8}, pts_tri);
+	scene.creer_objet<ObjetComposite_LignesMilieu>(pts_tri, indice_refr_lambda);
+}
+
+// Brouillard diffusant avec source "laser", source en secteur et ciel (main_brouillard.cpp)
+//
+static void scene_demo_brouillard (Scene& scene) {
+	creer_ecran_image(scene, /*x_obj*/0.5);
+	creer_ecrans_autour(scene, /*lumino*/0.0005, /*épaisseur*/0.01);
+	scene.ecrans_do([] (Ecran_Base& e) { e.luminosite *= 20; });
+	creer_source_unique_rayon(scene, point_t{1,0.445}, /*dir*/0.99*M_PI, /*ampl*/400.);
+	creer_source_omni_secteur(scene, point_t{0.7,0.60}, /*ang_ext*/0.1, /*ang_base*/1.05*M_PI, /*dens_ray*/10000);
+	creer_ciel_bleu(scene, /*dens lin*/300);
+	const float dens_brouillard = 100;
+	const float taille_brouill = 0.25;
+	const float resol_brouill = 0.01;
+	const size_t sz_brouill = taille_brouill/resol_brouill;
+	auto brouillard = scene.creer_objet<Objet_Brouillard>(
+		point_t{0.3,0.4}, resol_brouill, resol_brouill, sz_brouill, sz_brouill,
+		[=] (uint ix, uint iy) -> float {
+			float x = (ix-sz_brouill/2.)/(sz_brouill/2.);
+			float y = (iy-sz_brouill/2.)/(sz_brouill/2.);
+			return dens_brouillard * std::max(0.f, 1 - expf(x*x + y*y - 1));
+		});
+	brouillard->n_re_emit_par_intens = 2;
+	brouillard->intens_cutoff = 0.2;
+}
+
+///------------------------ Table des scènes ------------------------///
+
+namespace {
+	struct scene_demo_t {
+		const char* nom;
+		void (*construire) (Scene&);
+	};
+	const scene_demo_t scenes_demo [] = {
+		{ "store", &scene_demo_store },
+		{ "diffus", &scene_demo_diffus },
+		{ "milieux", &scene_demo_milieux },
+		{ "brouillard", &scene_demo_brouillard },
+	};
+}
+
+std::vector<std::string> scenes_demo_noms () {
+	std::vector<std::string> noms;
+	for (const scene_demo_t& s : scenes_demo)
+		noms.push_back(s.nom);
+	return noms;
+}
+
+bool scene_demo_construire (const std::string& nom, Scene& scene) {
+	for (const scene_demo_t& s : scenes_demo) {
+		if (nom == s.nom) {
+			// paramètres de propagation de Scene_TestCommon
+			scene.intens_cutoff = 1e-3;
+			scene.propag_profondeur_recur_max = 50;
+			s.construire(scene);
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,22 @@
+/*******************************************************************************
+ * Scènes de démonstration sans affichage : mêmes objets et sources que les
+ *  programmes main_*.cpp, construits directement dans une `Scene`, pour une
+ *  utilisation sans SFML (lightrays-run, mesures de performance…).
+ *******************************************************************************/
+
+#ifndef _LIGHTRAYS_SCENES_DEMO_H_
+#define _LIGHTRAYS_SCENES_DEMO_H_
+
+#include "Scene.h"
+#include <string>
+#include <vector>
+
+// Noms des scènes de démonstration disponibles
+std::vector<std::string> scenes_demo_noms ();
+
+// Construction de la scène de démonstration `nom` dans `scene` (qui devrait être vide) :
+//  objets, sources, écrans autour de la scène et paramètres de propagation.
+// Renvoie `false` si la scène `nom` n'existe pas.
+bool scene_demo_construire (const std::string& nom, Scene& scene);
+
+#endif
@@ -8,7 +8,7 @@ const decltype(Source_Omni::directivite) Source_Omni::directivite_unif = [] (flo
 std::vector<Rayon> Source_UniqueRayon::genere_rayons () {
 	return { Rayon{
 		.orig = position,
-		.dir_angle = dir_angle,
+		.dir = vec_t::unitaire(dir_angle),
 		.spectre = spectre
 	} };
 };
@@ -16,11 +16,11 @@ std::vector<Rayon> Source_UniqueRayon::genere_rayons () {
 std::vector<Rayon> Source_LinParallels::genere_rayons () {
 	std::vector<Rayon> rayons;
 	size_t n_rayons = lroundf(dens_lin * !vec);
-	float seg_dir_angle = atan2f(vec.y, vec.x) - M_PI/2;
+	vec_t dir = vec_t::unitaire( atan2f(vec.y, vec.x) - M_PI/2 + dir_angle_rel );
 	for (size_t k = 0; k < n_rayons; k++) {
 		Rayon ray = {
 			.orig = a + vec * (float)k / n_rayons,
-			.dir_angle = seg_dir_angle + dir_angle_rel,
+			.dir = dir,
 			.spectre = spectre
 		};
 		rayons.push_back(std::move(ray));
@@ -31,19 +31,21 @@ std::vector<Rayon> Source_LinParallels::genere_rayons () {
 std::vector<Rayon> Source_PonctOmni::genere_rayons () {
 	std::vector<Rayon> rayons;
 	size_t n_rayons = lroundf(dens_ang);
+	// tirage par lot des directions aléatoires
+	std::vector<float> alea (dir_alea ? n_rayons : 0);
+	flux_alea_thread.rand01_lot(alea.data(), alea.size());
 	for (size_t k = 0; k < n_rayons; k++) {
+		float dir_angle = dir_alea ?
+			(float)(2*M_PI) * alea[k] :
+			(float)(2*M_PI * k) / n_rayons;
+		if (secteur.has_value() and not secteur->inclus(dir_angle))
+			continue;
 		Rayon rayon = {
 			.orig = position,
-			.dir_angle = dir_alea ?
-				(float)(2*M_PI) * rand01() :
-				(float)(2*M_PI * k) / n_rayons,
+			.dir = vec_t::unitaire(dir_angle),
 			.spectre = spectre
 		};
-		if (secteur.has_value() and not secteur->inclus(rayon.dir_angle))
-			continue;
-		rayon.spectre.for_each([&] (float, pola_t, float& I) {
-			I *= this->directivite( rayon.dir_angle );
-		});
+		rayon.spectre *= this->directivite( dir_angle );
 		rayons.push_back(std::move(rayon));
 	}
 	return rayons;
@@ -54,13 +56,11 @@ std::vector<Rayon> Source_SecteurDisqueLambertien::genere_rayons () {
 	size_t n_rayons = lroundf(dens_ang * ang.longueur()/(2*M_PI));
 	for (size_t k = 0; k < n_rayons; k++) {
 		Rayon ray = { .spectre = spectre };
-		ray.dir_angle = ang.beg() + ang.longueur() * ( dir_alea ? rand01() : ((float)k / n_rayons) );
-		ray.orig = position + R * vec_t{ .x = cosf(ray.dir_angle), .y = sinf(ray.dir_angle) };
+		float theta = ang.beg() + ang.longueur() * ( dir_alea ? rand01() : ((float)k / n_rayons) );
+		ray.orig = position + R * vec_t::unitaire(theta);
 		float incr_angle = M_PI/2 * (1-2*rand01());
-		ray.spectre.for_each([&] (float, pola_t, float& I) {
-			I *= this->directivite( ray.dir_angle ) * cosf(incr_angle);
-		});
-		ray.dir_angle += incr_angle;
+		ray.spectre *= this->directivite( theta ) * cosf(incr_angle);
+		ray.dir = vec_t::unitaire(theta + incr_angle);
 		rayons.push_back(std::move(ray));
 	}
 	return rayons;
@@ -70,16 +70,16 @@ std::vector<Rayon> Source_LinLambertien::genere_rayons () {
 	std::vector<Rayon> rayons;
 	size_t n_rayons = lroundf(dens_lin * !vec);
 	float dir_angle = atan2f(vec.y, vec.x) - M_PI/2;
+	std::vector<float> alea (n_rayons);
+	flux_alea_thread.rand01_lot(alea.data(), n_rayons);
 	for (size_t k = 0; k < n_rayons; k++) {
-		float incr_angle = M_PI/2 * (1-2*rand01());
+		float incr_angle = M_PI/2 * (1-2*alea[k]);
 		Rayon ray = {
 			.orig = a + vec * (float)k / n_rayons,
-			.dir_angle = dir_angle + incr_angle,
+			.dir = vec_t::unitaire(dir_angle + incr_angle),
 			.spectre = spectre
 		};
-		ray.spectre.for_each([&] (float, pola_t, float& I) {
-			I *= cosf(incr_angle);
-		});
+		ray.spectre *= cosf(incr_angle);
 		rayons.push_back(std::move(ray));
 	}
 	return rayons;
@@ -87,6 +87,8 @@ std::vector<Rayon> Source_LinLambertien::genere_rayons () {
 
 ///------------------------ Affichage ------------------------///
 
+#ifndef NOSFML
+
 #include "sfml_c01.hpp"
 
 void Source_UniqueRayon::dessiner (sf::RenderWindow& win) const {
@@ -128,3 +130,5 @@ void Source_LinParallels::dessiner (sf::RenderWindow& win) const {
 		sf::c01::buildLine(a, a+vec, sf::Color::Yellow)
 	);
 }
+
+#endif
@@ -7,7 +7,10 @@
 
 #include "Rayon.h"
 #include <vector>
+#include <functional>
+#ifndef NOSFML
 #include <SFML/Graphics/RenderWindow.hpp>
+#endif
 
 //------------------------------------------------------------------------------
 // Classe de base, abstraite, des sources. À priori, seulement définie par
@@ -31,8 +34,10 @@ public:
 	// génération des rayons
 	virtual std::vector<Rayon> genere_rayons () = 0;
 	
+#ifndef NOSFML
 	// dessin de la source
 	virtual void dessiner (sf::RenderWindow& window) const = 0;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -55,7 +60,9 @@ public:
 	// création de l'unique rayon
 	virtual std::vector<Rayon> genere_rayons () override;
 	
+#ifndef NOSFML
 	void dessiner (sf::RenderWindow& window) const override;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -81,7 +88,9 @@ public:
 	
 	virtual std::vector<Rayon> genere_rayons () override;
 	
+#ifndef NOSFML
 	void dessiner (sf::RenderWindow& window) const override;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -112,7 +121,9 @@ class Source_PonctOmni : public Source_Omni {
 public:
 	virtual std::vector<Rayon> genere_rayons () override;
 	
+#ifndef NOSFML
 	void dessiner (sf::RenderWindow& window) const override;
+#endif
 	
 	template<typename... Args> Source_PonctOmni (point_t pos, Args&&... x) : Source_Omni(pos, x...) {}
 	
@@ -138,7 +149,9 @@ public:
 	
 	virtual std::vector<Rayon> genere_rayons () override;
 	
+#ifndef NOSFML
 	void dessiner (sf::RenderWindow& window) const override;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -162,7 +175,9 @@ public:
 	
 	virtual std::vector<Rayon> genere_rayons () override;
 	
+#ifndef NOSFML
 	void dessiner (sf::RenderWindow& window) const override;
+#endif
 };
 
 #endif
\ No newline at end of file
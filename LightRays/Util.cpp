@@ -2,6 +2,7 @@
 #include <cmath>
 #include <stdexcept>
 #include <cassert>
+#include <cstdlib>
 
 float vec_t::operator! () const {
 	return hypotf(x, y);
@@ -13,6 +14,14 @@ vec_t vec_t::rotate (float theta) const {
 	         .y = s * x + c * y };
 }
 
+float vec_t::angle () const {
+	return atan2f(y, x);
+}
+
+vec_t vec_t::unitaire (float theta) {
+	return { .x = cosf(theta), .y = sinf(theta) };
+}
+
 point_t milieu_2points (point_t a, point_t b) {
 	return { .x = (a.x + b.x)/2, .y = (a.y + b.y)/2 };
 }
@@ -54,19 +63,27 @@ angle_interv_t::angle_interv_t (float theta_beg, float b) : a(theta_beg), l(0) {
 	l = b - a;
 	a = angle_mod2pi_02(a);
 //	assert(0 <= a and a <= 2*M_PI and 0 <= l and l <= 2*M_PI);
+	calculer_vec_a_b();
 }
 
 angle_interv_t::angle_interv_t (float lenght) : a(0), l(lenght) {
 	if (l < 0 or l > 2*M_PI+1e-6)
 		throw std::domain_error("invalid angle interval length");
+	calculer_vec_a_b();
 }
 
 angle_interv_t angle_interv_t::operator+ (float delta_theta) const {
 	angle_interv_t o = *this;
 	o.a = angle_mod2pi_02(a + delta_theta);
+	o.calculer_vec_a_b();
 	return o;
 }
 
+void angle_interv_t::calculer_vec_a_b () {
+	u_a = vec_t::unitaire(a);
+	u_b = vec_t::unitaire(a+l);
+}
+
 float angle_mod2pi_11 (float theta) {
 	while (theta > M_PI)
 		theta -= 2*M_PI;
@@ -87,11 +104,25 @@ bool angle_interv_t::inclus (float theta) const {
 	return (a <= theta and theta <= a+l);
 }
 
-std::pair<vec_t,vec_t> angle_interv_t::vec_a_b () const {
-	return { vec_t{ .x = cosf(a),   .y = sinf(a) },
-	         vec_t{ .x = cosf(a+l), .y = sinf(a+l) } };
+// Inclusion d'une direction par produits vectoriels avec les vecteurs de début et de fin : pour un
+//  intervalle d'au plus π, `v` doit être à gauche de `u_a` et à droite de `u_b`; au-delà, il suffit
+//  qu'il ne soit pas strictement dans l'intervalle complémentaire (de `u_b` à `u_a`, plus petit que π)
+//
+bool angle_interv_t::inclus (vec_t v) const {
+	if (l >= 2*M_PI)
+		return true;
+	float ca = u_a ^ v, cb = v ^ u_b;
+	if (l <= M_PI)
+		return ca >= 0 and cb >= 0 and (l > 0 or (u_a | v) > 0);
+	else
+		return ca >= 0 or cb >= 0;
 }
 
-float rand01 () {
-	return rand()/(float)RAND_MAX;
+// Clé d'un flux : hachages successifs de la graine et des identifiants
+//
+flux_alea_t flux_alea_t::cle (uint64_t graine, uint32_t frame, uint32_t source, uint32_t primaire) {
+	uint64_t h = melange(graine + incr);
+	h = melange(h ^ (((uint64_t)frame << 32) | source));
+	h = melange(h ^ primaire);
+	return { h };
 }
@@ -3,6 +3,10 @@
 
 #include <utility>
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
 
 #ifdef NOSTDOPTIONAL
 	#include <boost/optional.hpp>
@@ -30,9 +34,12 @@ struct vec_t {
 	vec_t operator-  ()        const { return vec_t{ -x, -y }; }
 	vec_t operator-  (vec_t o) const { return vec_t{ x-o.x, y-o.y }; }
 	float operator|  (vec_t o) const { return x*o.x + y*o.y ; }	// produit scalaire
+	float operator^  (vec_t o) const { return x*o.y - y*o.x ; }	// produit vectoriel (composante z)
 	float norm2      ()        const { return x*x + y*y; }		// norme au carré
 	float operator!  ()        const;							// norme
 	vec_t rotate     (float theta) const;						// rotation d'un angle `theta`
+	float angle      ()        const;							// angle à l'horizontale, dans [-π,+π]
+	static vec_t unitaire (float theta);						// vecteur unitaire d'angle `theta` à l'horizontale
 	vec_t rotate_p90 ()        const { return vec_t { -y, +x }; }
 	vec_t rotate_m90 ()        const { return vec_t { +y, -x }; }
 };
@@ -61,6 +68,8 @@ std::vector<point_t> homothetie_points (point_t around, float coeff, std::vector
 struct angle_interv_t {
 private:
 	float a, l; // angle de début (0 ≤ a ≤ 2π) et longueur de l'intervalle (0 ≤ l ≤ 2π)
+	vec_t u_a, u_b; // vecteurs unitaires des angles de début et de fin, calculés à la construction
+	void calculer_vec_a_b ();
 public:
 	angle_interv_t (const angle_interv_t&) = default;
 	static const angle_interv_t cercle_entier;
@@ -75,9 +84,10 @@ public:
 	angle_interv_t operator+ (float delta_theta) const;	// rotation de l'intervalle
 	float longueur () const { return l; }				// longueur de l'intervalle, entre 0 et 2π
 	bool inclus (float theta) const;					// test si un angle (dans ℝ/2πℝ) est inclus dans l'intervalle
+	bool inclus (vec_t v) const;						// test si la direction de `v` est incluse dans l'intervalle (sans trigonométrie)
 	float beg () const { return a; }					// angle de début, entre 0 et 2π
 	float end () const { return a+l; }					// angle de fin, entre 0 et 4π
-	std::pair<vec_t,vec_t> vec_a_b () const;			// vecteurs unité définissant les angles début et fin
+	std::pair<vec_t,vec_t> vec_a_b () const { return {u_a, u_b}; }	// vecteurs unité définissant les angles début et fin
 };
 
 // réduit un angle à [-π,+π]
@@ -92,7 +102,81 @@ float angle_mod2pi_02 (float);
 // ⎣c  d⎦ ⎣y⎦ = ⎣f⎦
 void mat22_sol (float a, float b, float c, float d, float e, float f, float& x, float& y);
 
-// Nombre au hasard entre 0 et 1
-float rand01 ();
+/// Tables d'interpolation
+// Fonction tabulée en `n` points équirépartis de `x_min` à `x_max`, interpolée linéairement
+//  (valeurs aux bords hors de l'intervalle). Remplace l'appel d'une `std::function` coûteuse.
+struct table1d_t {
+	float x_min = 0, pas_inv = 0;
+	std::vector<float> v;
+	template <typename F> void tabuler (float x_min, float x_max, size_t n, F&& f) {
+		this->x_min = x_min;
+		pas_inv = (n - 1) / (x_max - x_min);
+		v.resize(n);
+		for (size_t i = 0; i < n; i++)
+			v[i] = f(x_min + i / pas_inv);
+	}
+	float operator() (float x) const {
+		float u = std::clamp((x - x_min) * pas_inv, 0.f, (float)(v.size() - 1));
+		size_t i = std::min<size_t>(u, v.size() - 2);
+		return v[i] + (u - i) * (v[i+1] - v[i]);
+	}
+};
+// Idem en 2D, `n` × `n` points sur [`x_min`,`x_max`]², interpolation bilinéaire
+struct table2d_t {
+	float x_min = 0, pas_inv = 0;
+	size_t n = 0;
+	std::vector<float> v;
+	template <typename F> void tabuler (float x_min, float x_max, size_t n, F&& f) {
+		this->x_min = x_min;
+		this->n = n;
+		pas_inv = (n - 1) / (x_max - x_min);
+		v.resize(n * n);
+		for (size_t i = 0; i < n; i++)
+			for (size_t j = 0; j < n; j++)
+				v[i*n + j] = f(x_min + i / pas_inv, x_min + j / pas_inv);
+	}
+	float operator() (float x, float y) const {
+		float u = std::clamp((x - x_min) * pas_inv, 0.f, (float)(n - 1)),
+		      w = std::clamp((y - x_min) * pas_inv, 0.f, (float)(n - 1));
+		size_t i = std::min<size_t>(u, n - 2),
+		       j = std::min<size_t>(w, n - 2);
+		u -= i; w -= j;
+		const float* p = &v[i*n + j];
+		return (1-u) * ((1-w) * p[0] + w * p[1])
+		     +    u  * ((1-w) * p[n] + w * p[n+1]);
+	}
+};
+
+/// Nombres aléatoires
+// Flux de nombres aléatoires reproductibles, identifiés par une clé (graine, frame, source, rayon primaire).
+// La scène sélectionne le flux du thread avant l'émission par chaque source et avant la propagation de
+//  chaque rayon primaire : les tirages des rebonds successifs d'un rayon primaire sont faits dans l'ordre
+//  fixe du parcours en profondeur, donc les résultats ne dépendent ni du nombre de threads ni de l'ordonnancement.
+// Générateur à compteur (SplitMix64) : l'état est un compteur 64 bits incrémenté à chaque tirage,
+//  le nombre tiré est un hachage du compteur (tirages par lot vectorisables).
+struct flux_alea_t {
+	uint64_t compteur;
+	static constexpr uint64_t incr = 0x9e3779b97f4a7c15ull;
+	static uint64_t melange (uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+	static flux_alea_t cle (uint64_t graine, uint32_t frame, uint32_t source, uint32_t primaire);
+	uint64_t suivant () { return melange(compteur += incr); }
+	// nombre au hasard dans [0,1[ (24 bits de mantisse)
+	float rand01 () { return (suivant() >> 40) * 0x1p-24f; }
+	// `n` nombres au hasard dans [0,1[, identiques à `n` appels à `rand01()`
+	void rand01_lot (float* x, size_t n) {
+		for (size_t i = 0; i < n; i++)
+			x[i] = (melange(compteur + (i+1) * incr) >> 40) * 0x1p-24f;
+		compteur += n * incr;
+	}
+};
+
+// Flux courant du thread (initialisation constante : pas de coût d'accès), et nombre au hasard
+//  dans [0,1[ tiré de ce flux
+inline thread_local flux_alea_t flux_alea_thread = { 0x853c49e6748fea9bull };
+inline float rand01 () { return flux_alea_thread.rand01(); }
 
 #endif
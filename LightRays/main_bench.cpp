@@ -0,0 +1,112 @@
+/********************************************************************************
+ * Mesures de performance sans affichage : propagation des scènes de
+ * démonstration avec graine et nombre de frames fixés, résultats en JSON
+ * (rayons/s, nombre de rayons, profondeur moyenne, temps par phase).
+ * Ne dépend pas de SFML (compilé avec -DNOSFML).
+ ********************************************************************************/
+
+#include "ScenesDemo.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+// Scènes mesurées et nombre de frames (~ une seconde chacune en mono-thread)
+struct fixture_t {
+	const char* scene;
+	size_t n_frames;
+};
+static const fixture_t fixtures [] = {
+	{ "store", 200 },
+	{ "diffus", 200 },
+	{ "milieux", 200 },
+	{ "brouillard", 100 },
+};
+
+struct resultat_t {
+	const char* scene;
+	size_t n_frames;
+	Scene::stats_t stats;
+	Scene::temps_t temps;
+	double temps_commit, temps_total;
+};
+
+// Mesure d'une scène : une frame de chauffe (allocations des tampons), puis `n_frames` mesurées
+//
+static resultat_t mesurer (const fixture_t& fix, size_t n_threads, bool par_lots, unsigned graine) {
+	Scene scene;
+	scene_demo_construire(fix.scene, scene);
+	scene.graine_alea = graine;
+	scene.propag_n_threads = n_threads;
+	scene.propag_par_lots = par_lots;
+
+	scene.emission_propagation();
+	scene.ecrans_do([] (Ecran_Base& e) { e.reset(); });
+	scene.stats = {};
+	scene.temps = {};
+
+	double temps_commit = 0;
+	auto t_debut = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < fix.n_frames; frame++) {
+		scene.emission_propagation();
+		auto t = std::chrono::steady_clock::now();
+		scene.ecrans_do([] (Ecran_Base& e) { e.commit(); });
+		temps_commit += std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+	}
+	double temps_total = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_debut).count();
+
+	return { fix.scene, fix.n_frames, scene.stats, scene.temps, temps_commit, temps_total };
+}
+
+static void ecrire_json (std::ostream& f, const std::vector<resultat_t>& resultats, size_t n_threads, bool par_lots, unsigned graine) {
+	f << "{" << std::endl;
+	f << "  \"n_couleurs\": " << N_COULEURS << "," << std::endl;
+	f << "  \"threads\": " << n_threads << "," << std::endl;
+	f << "  \"par_lots\": " << (par_lots ? "true" : "false") << "," << std::endl;
+	f << "  \"graine\": " << graine << "," << std::endl;
+	f << "  \"fixtures\": [" << std::endl;
+	for (size_t i = 0; i < resultats.size(); i++) {
+		const resultat_t& r = resultats[i];
+		f << "    {" << std::endl;
+		f << "      \"scene\": \"" << r.scene << "\"," << std::endl;
+		f << "      \"frames\": " << r.n_frames << "," << std::endl;
+		f << "      \"rayons\": " << r.stats.n_rayons << "," << std::endl;
+		f << "      \"rayons_emis\": " << r.stats.n_rayons_emis << "," << std::endl;
+		f << "      \"rayons_jetes\": " << r.stats.n_rayons_discarded << "," << std::endl;
+		f << "      \"rayons_profmax\": " << r.stats.n_rayons_profmax << "," << std::endl;
+		f << "      \"intens_jetee\": " << r.stats.intens_jetee << "," << std::endl;
+		f << "      \"intens_roulette\": " << r.stats.intens_roulette << "," << std::endl;
+		f << "      \"rayons_par_s\": " << (r.stats.n_rayons / r.temps_total) << "," << std::endl;
+		f << "      \"prof_recur_moy\": " << (r.stats.sum_prof_recur / (double)std::max<uint64_t>(1, r.stats.n_rayons)) << "," << std::endl;
+		f << "      \"temps_s\": { \"total\": " << r.temps_total << ", \"bvh\": " << r.temps.bvh
+		  << ", \"emission\": " << r.temps.emission << ", \"propagation\": " << r.temps.propagation
+		  << ", \"commit\": " << r.temps_commit << " }" << std::endl;
+		f << "    }" << (i+1 < resultats.size() ? "," : "") << std::endl;
+	}
+	f << "  ]" << std::endl;
+	f << "}" << std::endl;
+}
+
+int main (int argc, char const** argv) {
+
+	if (argc > 5) {
+		std::cerr << "Usage : lightrays-bench [threads=1] [lots=0|1] [graine=1] [fichier.json=stdout]" << std::endl;
+		return 1;
+	}
+	size_t n_threads = (argc > 1) ? std::max(1ul, std::stoul(argv[1])) : 1;
+	bool par_lots = (argc > 2) ? std::stoi(argv[2]) != 0 : false;
+	unsigned graine = (argc > 3) ? std::stoul(argv[3]) : 1;
+
+	std::vector<resultat_t> resultats;
+	for (const fixture_t& fix : fixtures) {
+		resultats.push_back( mesurer(fix, n_threads, par_lots, graine) );
+		const resultat_t& r = resultats.back();
+		std::cerr << fix.scene << " : " << r.stats.n_rayons / r.temps_total << " rayons/s" << std::endl;
+	}
+
+	if (argc > 4) {
+		std::ofstream f (argv[4]);
+		ecrire_json(f, resultats, n_threads, par_lots, graine);
+	} else
+		ecrire_json(std::cout, resultats, n_threads, par_lots, graine);
+	return 0;
+}
@@ -49,6 +49,7 @@ int main (int, char const**) {
 		L"[T/Y] brouillard moins/plus diffusant",
 		L"[M] change méthode diffusion (totale/partielle)",
 		L"[P] parcours brouillard déterministe ou non",
+		L"[W] suivi par majorant (Woodcock) ou par cellules",
 		L""
 	});
 	
@@ -56,10 +57,12 @@ int main (int, char const**) {
 	/*f_event*/ [&] (sf::Event event) {
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::T) { // diminution de la densité du brouillard
 			dens_brouillard *= 0.9;
+			brouillard->densit_modifiee();
 			scene.reset_ecrans = true;
 		}
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::Y) { // augmentation de la densité du brouillard
 			dens_brouillard *= 1.1;
+			brouillard->densit_modifiee();
 			scene.reset_ecrans = true;
 		}
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::M) { // changement de méthode de diffusion
@@ -78,6 +81,10 @@ int main (int, char const**) {
 			brouillard->parcours_deterministe = !brouillard->parcours_deterministe;
 			scene.reset_ecrans = true;
 		}
+		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::W) { // suivi du rayon par majorant ou cellule par cellule
+			brouillard->suivi_delta = !brouillard->suivi_delta;
+			scene.reset_ecrans = true;
+		}
 	}, /*f_pre_propag*/ nullptr, /*f_post_propag*/ nullptr);
 
     return 0;
@@ -48,9 +48,9 @@ int main (int, char const**) {
 	std::vector<propag_debug_rayons_t> propag_debug_rayons;
 	bool propag_debug = false;
 	
-	auto propag_intercept_debug_info_mouse = [&] (Objet& o, const Rayon& ray, std::shared_ptr<void> intercept_struct) {
+	auto propag_intercept_debug_info_mouse = [&] (Objet& o, const Rayon& ray, const Objet::intercept_struct_t& intercept_struct) {
 		if (dynamic_cast<ObjetCourbe*>(&o) != nullptr) { // si c'est un ObjetCourbe (sinon le point d'interception n'est pas défini)
-			ObjetArc::intercept_courbe_t& intercept = *std::static_pointer_cast<ObjetArc::intercept_courbe_t>(intercept_struct);
+			const ObjetArc::intercept_courbe_t& intercept = intercept_struct.get<ObjetArc::intercept_courbe_t>();
 			propag_debug_rayons.push_back(propag_debug_rayons_t{
 				.milieu_rayon = milieu_2points(ray.orig, intercept.p_incid),
 				.ray = ray,
@@ -97,9 +97,9 @@ int main (int, char const**) {
 			scene.win_scene->draw(point_milieu);
 			auto text = sf::c01::buildText(scene.font, closest_rayon->milieu_rayon, {
 				fmt::format(L"orig : ( {:.3f}, {:.3f} )", ray.orig.x, ray.orig.y),
-				fmt::format(L"angle : {:.2f}π", ray.dir_angle/M_PI),
+				fmt::format(L"angle : {:.2f}π", ray.dir.angle()/M_PI),
 				fmt::format(L"incid : ( {:.3f}, {:.3f} )", closest_rayon->intercept.p_incid.x, closest_rayon->intercept.p_incid.y),
-				fmt::format(L"angle incid : {:.2f}π/2 {}", closest_rayon->intercept.ang_incid/(M_PI/2), closest_rayon->intercept.sens_reg ? L"reg" : L"inv"),
+				fmt::format(L"angle incid : {:.2f}π/2 {}", closest_rayon->intercept.ang_incid(ray.dir)/(M_PI/2), closest_rayon->intercept.sens_reg ? L"reg" : L"inv"),
 				fmt::format(L"I n°1 TE : {:.3e}", ray.spectre.comps[2]),
 				fmt::format(L"I n°1 TM : {:.3e}", ray.spectre.comps[3]),
 			}, sf::Color::White);
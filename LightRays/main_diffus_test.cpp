@@ -79,20 +79,24 @@ int main (int, char const**) {
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::W) { // réflexion spéculaire plus piquée
 			diffus_n = 2*diffus_n+1;
 			diffus_c = diffus_c_calc(diffus_n);
+			panel_diffus->BRDF_modifiee();
 			scene.reset_ecrans = true;
 		}
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::X) { // réflexion spéculaire moins piquée
 			if (diffus_n > 1)
 				diffus_n = (diffus_n-1)/2;
 			diffus_c = diffus_c_calc(diffus_n);
+			panel_diffus->BRDF_modifiee();
 			scene.reset_ecrans = true;
 		}
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::V) { // plus de réflexion spéculaire
 			refl_spec = std::min<float>(1, refl_spec+0.02);
+			panel_diffus->BRDF_modifiee();
 			scene.reset_ecrans = true;
 		}
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::C) { // moins de réflexion spéculaire
 			refl_spec = std::max<float>(0, refl_spec-0.02);
+			panel_diffus->BRDF_modifiee();
 			scene.reset_ecrans = true;
 		}
 		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::E) { // étend la source
@@ -114,16 +118,12 @@ int main (int, char const**) {
 		}
 	},
 	/*f_pre_propag*/ [&] () {
-		// réinitialisation de `objet_bilan`
-		if (scene.reset_ecrans)
-			objet_bilan->reset();
 		// on fait toujours pointer la souce vers le centre du plan diffusant
 		vec_t v = panel_m - source_omni->position;
 		source_omni->secteur = angle_interv_t(-source_ext_ang,+source_ext_ang) + atan2f(v.y,v.x);
 	},
 	/*f_post_propag*/ [&] () {
-		// affichage du bilan d'énergie
-		objet_bilan->commit();
+		// affichage du bilan d'énergie (`objet_bilan` est commité et réinitialisé comme les écrans)
 		auto stat = objet_bilan->bilan();
 		float diff = stat.flux_in - stat.flux_out;
 		std::wstringstream s;
@@ -36,7 +36,10 @@ int main (int, char const**) {
 	std::function<float(float)> indice_refr_lambda = [] (float lambda) {
 		return 1 + 0.1 * lambda / lambda_color[N_COULEURS/2];
 	};
+	// une couleur tirée par rayon réfracté sur les objets dispersifs (sinon N_COULEURS rayons par dioptre)
+	bool dispersion_alea = true;
 	auto dioptre = std::make_shared<ObjetLigne_Milieux>(indice_refr_lambda, point_t{0.8,0.25}, point_t{0.85,0.35});
+	dioptre->dispersion_alea = dispersion_alea;
 	scene.objets.push_back(dioptre);
 	scene.ajouter_bouge_action(dioptre->a, [&] (point_t mouse, float angle, bool alt) -> point_t {
 		if (!alt) { dioptre->b = dioptre->b + (mouse - dioptre->a); dioptre->a = mouse; }
@@ -65,7 +68,7 @@ int main (int, char const**) {
 	
 	/// --------- Filtre ---------
 	
-	auto filtre_vert = scene.creer_objet<Objet_Filtre>((color_id_t)2, point_t{0.1,0.8}, point_t{0.2,0.8});
+	auto filtre_vert = scene.creer_objet<Objet_Filtre>(couleur_proche(5.3e-4), point_t{0.1,0.8}, point_t{0.2,0.8});
 	scene.ajouter_bouge_action(filtre_vert->a, [&] (point_t mouse, float angle, bool alt) -> point_t {
 		if (!alt) { filtre_vert->b = filtre_vert->b + (mouse - filtre_vert->a); filtre_vert->a = mouse; }
 		else filtre_vert->b = mouse;
@@ -85,14 +88,29 @@ int main (int, char const**) {
 		auto pts_tri = homothetie_points({0,0}, prisme_taille, pts_triangle);
 		pts_tri = rotate_points({0,0}, prisme_angle, pts_tri);
 		pts_tri = translate_points((vec_t)prisme_position, pts_tri);
-		*prisme_scene_it = std::make_shared<ObjetComposite_LignesMilieu>(pts_tri, indice_refr_lambda);
+		auto prisme = std::make_shared<ObjetComposite_LignesMilieu>(pts_tri, indice_refr_lambda);
+		prisme->dispersion_alea(dispersion_alea);
+		*prisme_scene_it = prisme;
 		return prisme_position;
 	};
 	prisme_move_action(prisme_position, 0, false);
 	scene.ajouter_bouge_action(prisme_position, prisme_move_action);
 	
 	
-	scene.boucle(nullptr, nullptr, nullptr);
+	scene.static_text.insert(scene.static_text.begin(), {
+		L"[A] dispersion : une couleur tirée ou toutes",
+		L""
+	});
+	
+	scene.boucle(
+	/*f_event*/ [&] (sf::Event event) {
+		if (event.type == sf::Event::KeyPressed and event.key.code == sf::Keyboard::A) { // dispersion par tirage d'une couleur ou séparation
+			dispersion_alea = !dispersion_alea;
+			dioptre->dispersion_alea = dispersion_alea;
+			std::dynamic_pointer_cast<ObjetComposite_LignesMilieu>(*prisme_scene_it)->dispersion_alea(dispersion_alea);
+			scene.reset_ecrans = true;
+		}
+	}, /*f_pre_propag*/ nullptr, /*f_post_propag*/ nullptr);
 	
 	return 0;
 }
@@ -0,0 +1,130 @@
+/********************************************************************************
+ * Exécution sans affichage d'une scène : propagation sur un nombre donné de
+ * frames (ou jusqu'à une erreur relative donnée) et de threads, puis
+ * enregistrement des écrans, de la carte de fluence et des statistiques.
+ * Ne dépend pas de SFML (compilé avec -DNOSFML).
+ ********************************************************************************/
+
+#include "ScenesDemo.h"
+#include "FichierScene.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+static void usage () {
+	std::cerr << "Usage : lightrays-run <scène|fichier> [frames=100] [threads=auto] [dossier=.] [erreur_rel]" << std::endl;
+	std::cerr << "Si erreur_rel est donnée, propagation jusqu'à cette erreur relative des écrans, en au plus `frames` frames" << std::endl;
+	std::cerr << "Fichier de scène : voir FichierScene.h; scènes de démonstration :";
+	for (const std::string& nom : scenes_demo_noms())
+		std::cerr << " " << nom;
+	std::cerr << std::endl;
+}
+
+// Enregistrement de la matrice de pixels d'un écran : une ligne par pixel,
+//  position sur l'écran, couleur affichée, saturation, composantes du spectre, puis erreur standard
+//  de l'intensité totale et nombre de rayons reçus
+//
+static void enregistrer_ecran (const EcranLigne_Multi& ecran, const std::filesystem::path& fichier) {
+	std::ofstream f (fichier);
+	if (not f)
+		throw std::runtime_error("Impossible d'écrire " + fichier.string());
+	f << "# a = (" << ecran.a.x << "," << ecran.a.y << "), b = (" << ecran.b.x << "," << ecran.b.y << ")" << std::endl;
+	f << "s\tr\tg\tb\tsat";
+	Specte::for_each_manual([&] (uint8_t i, float lambda, pola_t pol) {
+		f << "\tI_" << lambda*1e6 << "nm_" << (pol == PolTE ? "TE" : "TM");
+	});
+	f << "\terr\timpacts" << std::endl;
+	for (const EcranLigne_Multi::pixel_t& pix : ecran.matrice_pixels()) {
+		f << pix.s_mid << '\t' << (int)pix.r << '\t' << (int)pix.g << '\t' << (int)pix.b << '\t' << pix.sat;
+		pix.spectre.for_each([&] (float, pola_t, float I) { f << '\t' << I; });
+		f << '\t' << pix.erreur << '\t' << pix.n_impacts << std::endl;
+	}
+}
+
+int main (int argc, char const** argv) {
+
+	if (argc < 2 or argc > 6) {
+		usage();
+		return 1;
+	}
+	std::string nom_scene = argv[1];
+	size_t n_frames = (argc > 2) ? std::stoul(argv[2]) : 100;
+	size_t n_threads = (argc > 3) ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+	std::filesystem::path dossier = (argc > 4) ? argv[4] : ".";
+	float erreur_rel = (argc > 5) ? std::stof(argv[5]) : 0;
+
+	// Scène de démonstration, ou sinon fichier de description de scène
+	Scene scene;
+	if (not scene_demo_construire(nom_scene, scene)) {
+		try {
+			scene_charger_fichier(nom_scene, scene);
+		} catch (const std::runtime_error& e) {
+			std::cerr << e.what() << std::endl;
+			usage();
+			return 1;
+		}
+	}
+	scene.propag_n_threads = std::max<size_t>(1, n_threads);
+
+	// Propagation
+	auto t_debut = std::chrono::steady_clock::now();
+	if (erreur_rel > 0)
+		n_frames = scene.propagation_convergence(erreur_rel, n_frames);
+	else {
+		for (size_t frame = 0; frame < n_frames; frame++) {
+			scene.emission_propagation();
+			scene.ecrans_do([] (Ecran_Base& e) { e.commit(); });
+		}
+	}
+	double duree = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_debut).count();
+
+	// Enregistrement des écrans
+	std::filesystem::create_directories(dossier);
+	size_t i_ecran = 0;
+	for (auto& objet : scene.objets) {
+		auto ecran = std::dynamic_pointer_cast<EcranLigne_Multi>(objet);
+		if (ecran) {
+			std::ostringstream nom_fichier;
+			nom_fichier << "ecran_" << i_ecran++ << ".tsv";
+			enregistrer_ecran(*ecran, dossier / nom_fichier.str());
+		}
+	}
+
+	// Carte de fluence (directive `fluence` du fichier de scène) : flottants bruts et image
+	if (scene.fluence) {
+		scene.fluence->enregistrer_pfm((dossier / "fluence.pfm").string());
+		scene.fluence->enregistrer_pgm((dossier / "fluence.pgm").string());
+	}
+
+	// Enregistrement des statistiques (cumulées sur toutes les frames)
+	const Scene::stats_t& s = scene.stats;
+	std::ofstream f_stats (dossier / "stats.txt");
+	f_stats << "scene " << nom_scene << std::endl;
+	f_stats << "frames " << n_frames << std::endl;
+	f_stats << "threads " << scene.propag_n_threads << std::endl;
+	f_stats << "duree_s " << duree << std::endl;
+	f_stats << "rayons_emis " << s.n_rayons_emis << std::endl;
+	f_stats << "rayons " << s.n_rayons << std::endl;
+	f_stats << "rayons_jetes " << s.n_rayons_discarded << std::endl;
+	f_stats << "rayons_profmax " << s.n_rayons_profmax << std::endl;
+	f_stats << "roulette " << scene.propag_roulette << std::endl;
+	f_stats << "intens_jetee " << s.intens_jetee << std::endl;
+	f_stats << "intens_roulette " << s.intens_roulette << std::endl;
+	f_stats << "erreur_relative " << scene.erreur_relative_ecrans() << std::endl;
+	f_stats << "prof_recur_moy " << (s.sum_prof_recur / (double)std::max<uint64_t>(1, s.n_rayons)) << std::endl;
+	f_stats << "rayons_par_s " << (s.n_rayons / duree) << std::endl;
+
+#ifdef LIGHTRAYS_PROFIL
+	// Profil par objet (make PROFIL=1)
+	std::ofstream f_profil (dossier / "profil.txt");
+	scene.profil_tableau(f_profil);
+#endif
+
+	std::cout << nom_scene << " : " << n_frames << " frames, " << s.n_rayons << " rayons en " << duree << " s, "
+	          << i_ecran << " écrans enregistrés dans " << dossier << std::endl;
+	return 0;
+}
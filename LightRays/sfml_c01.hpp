@@ -41,6 +41,11 @@ namespace sf { namespace c01 {
 	inline sf::VertexArray buildLine (pt2_t a, pt2_t b, sf::Color color = sf::Color::Black) {
 		return sf::c01::buildLine(a, b, color, color);
 	}
+	// ajout d'un segment à un tableau de type sf::Lines (dessin de nombreux segments en un seul appel)
+	inline void appendLine (sf::VertexArray& lines, pt2_t a, pt2_t b, sf::Color color) {
+		lines.append( sf::Vertex( sf::c01::toWin(a), color ) );
+		lines.append( sf::Vertex( sf::c01::toWin(b), color ) );
+	}
 	
 	inline sf::ConvexShape buildParallelogram (pt2_t o, vec2_t va, vec2_t vb, sf::Color color) {
 		sf::ConvexShape polygon;
@@ -52,6 +57,13 @@ namespace sf { namespace c01 {
 		polygon.setFillColor(color);
 		return polygon;
 	}
+	// ajout d'un parallélogramme à un tableau de type sf::Quads
+	inline void appendParallelogram (sf::VertexArray& quads, pt2_t o, vec2_t va, vec2_t vb, sf::Color color) {
+		quads.append( sf::Vertex( sf::c01::toWin(o), color ) );
+		quads.append( sf::Vertex( sf::c01::toWin(o+va), color ) );
+		quads.append( sf::Vertex( sf::c01::toWin(o+va+vb), color ) );
+		quads.append( sf::Vertex( sf::c01::toWin(o+vb), color ) );
+	}
 	
 	inline pt2_t fromWin (sf::Vector2f v) {
 		return { .x = v.x/SFMLC01_WINDOW_UNIT, .y = 1.f-v.y/SFMLC01_WINDOW_UNIT };